@@ -2,6 +2,7 @@
 #define CONVEX_HULL_HPP
 
 #include <vector>
+#include <string>
 
 struct Point {
     double x, y;
@@ -20,4 +21,12 @@ std::vector<Point> convexHull(std::vector<Point> points);
 
 double polygonArea(const std::vector<Point>& vertices);
 
+// Parses a number at p (after optional whitespace); returns the position after it or nullptr
+const char* parseDouble(const char* p, const char* end, double& value);
+
+// Parses "x,y" into point without allocating; false if malformed
+bool parsePoint(const char* begin, const char* end, Point& point);
+
+bool parsePoint(const std::string& pointStr, Point& point);
+
 #endif // CONVEX_HULL_HPP
\ No newline at end of file
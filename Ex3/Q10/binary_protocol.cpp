@@ -0,0 +1,123 @@
+#include "binary_protocol.hpp"
+#include <cstring>
+#include <cmath>
+
+ProtocolDetect detectProtocol(const char* data, size_t len) {
+    // Text commands never start with NUL, so text clients are never held back
+    size_t n = len < BINARY_MAGIC_LEN ? len : BINARY_MAGIC_LEN;
+    if (memcmp(data, BINARY_MAGIC, n) != 0) return DETECT_TEXT;
+    return n == BINARY_MAGIC_LEN ? DETECT_BINARY : DETECT_NEED_MORE;
+}
+
+int nextFrame(const std::string& buf, size_t& pos, BinaryFrame& frame) {
+    if (buf.size() - pos < 4) return 0;
+
+    uint32_t length = getU32(buf.data() + pos);
+    if (length == 0 || length > MAX_FRAME_SIZE) return -1;
+    if (buf.size() - pos - 4 < length) return 0;
+
+    frame.opcode = static_cast<uint8_t>(buf[pos + 4]);
+    frame.payload = buf.data() + pos + 5;
+    frame.payloadLen = length - 1;
+    pos += 4 + length;
+    return 1;
+}
+
+// float32 counterpart of getF64
+static float getF32(const char* data) {
+    uint32_t bits = getU32(data);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool decodePoints(const BinaryFrame& frame, std::vector<Point>& points) {
+    bool float32 = (frame.opcode & OP_FLOAT32) != 0;
+    size_t pointSize = float32 ? 8 : 16;
+    if (frame.payloadLen % pointSize != 0) return false;
+
+    size_t count = frame.payloadLen / pointSize;
+    points.resize(count);
+    const char* p = frame.payload;
+    for (size_t i = 0; i < count; i++, p += pointSize) {
+        if (float32) {
+            points[i] = Point(getF32(p), getF32(p + 4));
+        } else {
+            points[i] = Point(getF64(p), getF64(p + 8));
+        }
+        // NaN would also break the strict weak ordering the hull sort relies on
+        if (!std::isfinite(points[i].x) || !std::isfinite(points[i].y)) return false;
+    }
+    return true;
+}
+
+void putU32(std::string& out, uint32_t value) {
+    char bytes[4];
+    for (int i = 0; i < 4; i++) bytes[i] = static_cast<char>(value >> (8 * i));
+    out.append(bytes, 4);
+}
+
+void putU64(std::string& out, uint64_t value) {
+    char bytes[8];
+    for (int i = 0; i < 8; i++) bytes[i] = static_cast<char>(value >> (8 * i));
+    out.append(bytes, 8);
+}
+
+void putF64(std::string& out, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putU64(out, bits);
+}
+
+void putPoints(std::string& out, const std::vector<Point>& points, bool float32) {
+    out.reserve(out.size() + points.size() * (float32 ? 8 : 16));
+    for (const Point& p : points) {
+        if (float32) {
+            float x = static_cast<float>(p.x), y = static_cast<float>(p.y);
+            uint32_t bits;
+            memcpy(&bits, &x, sizeof(bits));
+            putU32(out, bits);
+            memcpy(&bits, &y, sizeof(bits));
+            putU32(out, bits);
+        } else {
+            putF64(out, p.x);
+            putF64(out, p.y);
+        }
+    }
+}
+
+uint32_t getU32(const char* data) {
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(data);
+    return static_cast<uint32_t>(b[0]) | static_cast<uint32_t>(b[1]) << 8 |
+           static_cast<uint32_t>(b[2]) << 16 | static_cast<uint32_t>(b[3]) << 24;
+}
+
+uint64_t getU64(const char* data) {
+    return static_cast<uint64_t>(getU32(data)) | static_cast<uint64_t>(getU32(data + 4)) << 32;
+}
+
+double getF64(const char* data) {
+    uint64_t bits = getU64(data);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::string encodeRequest(uint8_t opcode, const std::string& payload) {
+    std::string frame;
+    frame.reserve(5 + payload.size());
+    putU32(frame, static_cast<uint32_t>(1 + payload.size()));
+    frame.push_back(static_cast<char>(opcode));
+    frame.append(payload);
+    return frame;
+}
+
+std::string encodeResponse(uint8_t opcode, uint8_t status, const std::string& payload) {
+    std::string frame;
+    frame.reserve(6 + payload.size());
+    putU32(frame, static_cast<uint32_t>(2 + payload.size()));
+    frame.push_back(static_cast<char>(opcode));
+    frame.push_back(static_cast<char>(status));
+    frame.append(payload);
+    return frame;
+}
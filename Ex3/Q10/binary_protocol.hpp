@@ -0,0 +1,86 @@
+#ifndef BINARY_PROTOCOL_HPP
+#define BINARY_PROTOCOL_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "convex_hull.hpp"
+
+// Opt-in binary protocol, sharing port 9034 with the text protocol.
+// After reading the text banner a client sends BINARY_MAGIC as its first
+// bytes; the server answers with an OP_HELLO frame and the rest of the
+// connection is framed:
+//
+//   request:  u32 length | u8 opcode | payload
+//   response: u32 length | u8 opcode | u8 status | payload
+//
+// length counts everything after itself. Integers and floats are
+// little-endian; point arrays are x,y pairs of float64, or of float32 when
+// the opcode carries OP_FLOAT32.
+
+#define BINARY_MAGIC "\0CHB\1"
+#define BINARY_MAGIC_LEN 5
+#define MAX_FRAME_POINTS (1u << 20) // float64 points one frame may carry; send more with OP_NEWPOINT
+#define MAX_FRAME_SIZE (1 + 16 * MAX_FRAME_POINTS) // Opcode and points: 16 MiB, what one peer can make us buffer
+
+enum BinaryOpcode : uint8_t {
+    OP_HELLO = 0x00,       // (server only)      -> empty
+    OP_NEWGRAPH = 0x01,    // points[]           -> u64 graph size
+    OP_CH = 0x02,          // empty              -> f64 hull area
+    OP_NEWPOINT = 0x03,    // points[]           -> u64 graph size
+    OP_REMOVEPOINT = 0x04, // point              -> u64 graph size, STATUS_NOT_FOUND if absent
+    OP_STATUS = 0x05,      // empty              -> u64 graph size
+    OP_FLOAT32 = 0x40      // Flag: the request's points are float32
+};
+
+enum BinaryStatus : uint8_t {
+    STATUS_OK = 0,
+    STATUS_NOT_FOUND = 1,
+    STATUS_BAD_REQUEST = 2,
+    STATUS_UNKNOWN_OPCODE = 3
+};
+
+// Which protocol a connection speaks, judged from its first bytes
+enum ProtocolDetect {
+    DETECT_NEED_MORE,
+    DETECT_TEXT,
+    DETECT_BINARY
+};
+
+// A request frame; payload points into the receive buffer
+struct BinaryFrame {
+    uint8_t opcode;
+    const char* payload;
+    size_t payloadLen;
+};
+
+// Looks for BINARY_MAGIC at the start of the stream
+ProtocolDetect detectProtocol(const char* data, size_t len);
+
+// Takes the next complete frame off buf at pos.
+// Returns 1 for a frame, 0 if more bytes are needed, -1 for a malformed frame
+int nextFrame(const std::string& buf, size_t& pos, BinaryFrame& frame);
+
+// Decodes the frame's point array; false if the payload is not whole points
+// or a coordinate is not finite (as the text protocol rejects them)
+bool decodePoints(const BinaryFrame& frame, std::vector<Point>& points);
+
+// Little-endian encoders
+void putU32(std::string& out, uint32_t value);
+void putU64(std::string& out, uint64_t value);
+void putF64(std::string& out, double value);
+void putPoints(std::string& out, const std::vector<Point>& points, bool float32);
+
+// Little-endian decoders
+uint32_t getU32(const char* data);
+uint64_t getU64(const char* data);
+double getF64(const char* data);
+
+// Builds a request frame
+std::string encodeRequest(uint8_t opcode, const std::string& payload);
+
+// Builds a response frame
+std::string encodeResponse(uint8_t opcode, uint8_t status, const std::string& payload);
+
+#endif // BINARY_PROTOCOL_HPP
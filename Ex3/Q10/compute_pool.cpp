@@ -0,0 +1,48 @@
+#include "compute_pool.hpp"
+
+ComputePool::ComputePool(unsigned threads) {
+    if (threads == 0) {
+        unsigned cores = std::thread::hardware_concurrency();
+        threads = cores > 1 ? cores - 1 : 1;
+    }
+    for (unsigned i = 0; i < threads; i++) {
+        workers.emplace_back(&ComputePool::workerLoop, this);
+    }
+}
+
+ComputePool::~ComputePool() {
+    shutdown();
+}
+
+void ComputePool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        stopping = true;
+    }
+    jobsCond.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void ComputePool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        jobs.push_back(std::move(job));
+    }
+    jobsCond.notify_one();
+}
+
+void ComputePool::workerLoop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(jobsMutex);
+            jobsCond.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) return; // Stopping and nothing left to run
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef COMPUTE_POOL_HPP
+#define COMPUTE_POOL_HPP
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+// Fixed set of worker threads running heavy jobs off the client threads
+class ComputePool {
+public:
+    // Starts the workers; 0 picks one per core, keeping a core for the client threads
+    explicit ComputePool(unsigned threads = 0);
+
+    // Finishes queued jobs and joins the workers
+    ~ComputePool();
+
+    // What the destructor does, for owners that exit without unwinding.
+    // Jobs submitted afterwards never run
+    void shutdown();
+
+    // Queues job to run on some worker
+    void submit(std::function<void()> job);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex jobsMutex;
+    std::condition_variable jobsCond;
+    bool stopping = false;
+};
+
+#endif // COMPUTE_POOL_HPP
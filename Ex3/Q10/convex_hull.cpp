@@ -1,39 +1,61 @@
 #include "convex_hull.hpp"
+#include "monotone_chain.hpp"
+#include "logger.hpp"
 #include "reactor_proactor.hpp"
+#include "binary_protocol.hpp"
+#include "server_stats.hpp"
 #include <iostream>
 #include <vector>
 #include <string>
-#include <sstream>
 #include <algorithm>
+#include <new>
 #include <cmath>
-#include <iomanip>
+#include <cstdlib>
+#include <cstdint>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
+#include <cstdio>
+#include <cerrno>
 #include <thread>
 #include <mutex>
 #include <atomic>
 #include <csignal>
+#include <chrono>
+#include <poll.h>
+#include <sys/eventfd.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 #define PORT 9034
-#define BUFSIZE 1024
+#define BUFSIZE 65536
 
-// Global graph data structure shared by all clients
-std::vector<Point> globalGraph;
-int counter = 0;
-std::mutex graphMutex; // Mutex to protect shared graph resource
+// Named graphs shared by all clients
+std::map<std::string, std::shared_ptr<Graph>> graphs;
+InstrumentedMutex graphsMutex(LOCK_GRAPHS); // Only guards the map; each graph has its own lock
 std::atomic<bool> serverRunning{true}; 
+std::atomic<bool> statsRequested{false}; // SIGUSR1 seen; main prints the stats
 int globalServerSocket = -1;
 
-// For the CH area watcher thread
-std::mutex chAreaMutex;
-std::condition_variable chAreaCond;
-double lastCHArea = 0.0;
-std::atomic<bool> chAreaAtLeast100{false};
-std::atomic<bool> watcherRunning{true};
-pthread_t watcherThread;
+// CHAsync tickets and the workers computing them
+std::map<unsigned long, HullTicket> hullTickets;
+std::deque<unsigned long> finishedTickets; // Oldest first, for trimming hullTickets
+unsigned long nextTicket = 1;
+unsigned long runningHulls = 0; // Tickets submitted and not done yet
+InstrumentedMutex ticketsMutex(LOCK_TICKETS); // Protects the four above
+ComputePool* hullPool = nullptr;
+
+// Stats slots of the input handled outside commandTable; its rows follow from STAT_COMMANDS
+enum StatSlot {
+    STAT_POINT,      // A point line while a graph is being filled
+    STAT_LOADPOINTS, // From the Loadpoints line until its payload is stored
+    STAT_BINARY,     // One binary frame
+    STAT_UNKNOWN,
+    STAT_COMMANDS
+};
 
 Point::Point(double x, double y) : x(x), y(y) {}
 
@@ -59,40 +81,15 @@ void signalHandler(int signum) {
         if (globalServerSocket != -1) {
             close(globalServerSocket);
         }
+    } else if (signum == SIGUSR1) {
+        statsRequested = true;
     }
 }
 
 // Calculate convex hull using Andrew's monotone chain algorithm
 std::vector<Point> convexHull(std::vector<Point> points) {
-    int n = points.size();
-    if (n <= 1) return points;
-    
-    // Sort points lexicographically
-    std::sort(points.begin(), points.end());
-    
-    // Build lower hull
     std::vector<Point> hull;
-    for (int i = 0; i < n; i++) {
-        while (hull.size() >= 2 && 
-               crossProduct(hull[hull.size()-2], hull[hull.size()-1], points[i]) <= 0) {
-            hull.pop_back();
-        }
-        hull.push_back(points[i]);
-    }
-    
-    // Build upper hull
-    size_t t = hull.size() + 1;
-    for (int i = n - 2; i >= 0; i--) {
-        while (hull.size() >= t && 
-               crossProduct(hull[hull.size()-2], hull[hull.size()-1], points[i]) <= 0) {
-            hull.pop_back();
-        }
-        hull.push_back(points[i]);
-    }
-    
-    // Remove the last point because it's the same as the first
-    hull.pop_back();
-    
+    monotoneChain(points, hull);
     return hull;
 }
 
@@ -111,123 +108,1666 @@ double polygonArea(const std::vector<Point>& vertices) {
     return std::abs(area) / 2.0;
 }
 
+double polygonPerimeter(const std::vector<Point>& vertices) {
+    size_t n = vertices.size();
+    if (n < 2) return 0.0;
+
+    double perimeter = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        const Point& a = vertices[i];
+        const Point& b = vertices[(i + 1) % n];
+        perimeter += std::hypot(b.x - a.x, b.y - a.y);
+    }
+    return perimeter;
+}
+
+HullStats measureHull(const std::vector<Point>& hull) {
+    HullStats stats;
+    stats.area = polygonArea(hull);
+    stats.perimeter = polygonPerimeter(hull);
+    stats.vertices = hull.size();
+    return stats;
+}
+
+// measureHull of a freshly computed hull, timed for Stats
+static HullStats timedMeasureHull(const std::vector<Point>& hull) {
+    uint64_t started = statsNow();
+    HullStats stats = measureHull(hull);
+    recordHullPhase(HULL_AREA, statsNow() - started);
+    return stats;
+}
+
+// Hull of a snapshot (sorted in place), each phase timed for Stats
+static HullStats timedHull(std::vector<Point>& points, std::vector<Point>& hull) {
+    uint64_t started = statsNow();
+    LexicographicSort()(points.begin(), points.end());
+    uint64_t sorted = statsNow();
+    recordHullPhase(HULL_SORT, sorted - started);
+    hull.clear();
+    chainSortedPoints<CrossProductOrientation>(points, hull);
+    recordHullPhase(HULL_SCAN, statsNow() - sorted);
+    return timedMeasureHull(hull);
+}
+
+// Whitespace as accepted around numbers (C locale, no function call)
+static inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// '0'..'9' with a single comparison
+static inline bool isDigit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// Powers of ten that are exact doubles
+static const double exactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Parse a decimal number (sign, fraction, exponent) starting at p, skipping
+// leading whitespace. Returns the position after it, or nullptr if there is
+// no finite number there. Never allocates and ignores the locale.
+const char* parseDouble(const char* p, const char* end, double& value) {
+    while (p < end && isSpace(*p)) p++;
+    const char* start = p;
+
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    // Accumulate every digit; only trusted below when there are at most 19
+    uint64_t mantissa = 0;
+    const char* digitsStart = p;
+    while (p < end && isDigit(*p)) {
+        mantissa = mantissa * 10 + (*p - '0');
+        p++;
+    }
+    int digits = static_cast<int>(p - digitsStart);
+    int exponent = 0;  // Power of ten applied to mantissa
+    if (p < end && *p == '.') {
+        const char* fraction = ++p;
+        while (p < end && isDigit(*p)) {
+            mantissa = mantissa * 10 + (*p - '0');
+            p++;
+        }
+        exponent = -static_cast<int>(p - fraction);
+        digits -= exponent;
+    }
+    if (digits == 0) return nullptr;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool expNegative = false;
+        if (q < end && (*q == '+' || *q == '-')) {
+            expNegative = (*q == '-');
+            q++;
+        }
+        if (q < end && isDigit(*q)) {
+            int e = 0;
+            for (; q < end && isDigit(*q); q++) {
+                if (e < 100000) e = e * 10 + (*q - '0');
+            }
+            exponent += expNegative ? -e : e;
+            p = q;
+        }
+    }
+
+    // Exact when both the mantissa and the power of ten are exact doubles
+    if (digits <= 19 && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        double v = static_cast<double>(mantissa);
+        v = exponent < 0 ? v / exactPowersOfTen[-exponent] : v * exactPowersOfTen[exponent];
+        value = negative ? -v : v;
+        return p;
+    }
+
+    // Rare long or extreme inputs: let strtod round them correctly
+    char text[128];
+    size_t len = p - start;
+    if (len >= sizeof(text)) return nullptr;
+    memcpy(text, start, len);
+    text[len] = '\0';
+    value = strtod(text, nullptr);
+    if (!std::isfinite(value)) return nullptr;
+    return p;
+}
+
+// Parse point "x,y" from [begin, end); whitespace around the numbers is allowed
+bool parsePoint(const char* begin, const char* end, Point& point) {
+    double x, y;
+    const char* p = parseDouble(begin, end, x);
+    if (!p) return false;
+    while (p < end && isSpace(*p)) p++;
+    if (p == end || *p != ',') return false;
+
+    p = parseDouble(p + 1, end, y);
+    if (!p) return false;
+    while (p < end && isSpace(*p)) p++;
+    if (p != end) return false;
+
+    point = Point(x, y);
+    return true;
+}
+
 // Parse point from string "x,y"
-Point parsePoint(const std::string& pointStr) {
-    size_t commaPos = pointStr.find(',');
-    if (commaPos != std::string::npos) {
-        double x = std::stod(pointStr.substr(0, commaPos));
-        double y = std::stod(pointStr.substr(commaPos + 1));
-        return Point(x, y);
+bool parsePoint(const std::string& pointStr, Point& point) {
+    return parsePoint(pointStr.data(), pointStr.data() + pointStr.size(), point);
+}
+
+// Bitmask of the whitespace bytes among the 64 bytes at p (bit i = p[i]);
+// a window cut short by end only reports the bytes before end
+static uint64_t whitespaceBits(const char* p, const char* end) {
+    if (end - p < 64) {
+        uint64_t bits = 0;
+        for (int i = 0; p + i < end; i++) {
+            if (isSpace(p[i])) bits |= 1ULL << i;
+        }
+        return bits;
+    }
+#if defined(__AVX2__)
+    // ' ' or '\t'..'\r'; bytes >= 0x80 compare as negative and never match
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i low = _mm256_set1_epi8('\t' - 1);
+    const __m256i high = _mm256_set1_epi8('\r' + 1);
+    uint64_t bits = 0;
+    for (int i = 0; i < 64; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+            _mm256_and_si256(_mm256_cmpgt_epi8(v, low), _mm256_cmpgt_epi8(high, v)));
+        bits |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(ws))) << i;
+    }
+    return bits;
+#elif defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i low = _mm_set1_epi8('\t' - 1);
+    const __m128i high = _mm_set1_epi8('\r' + 1);
+    uint64_t bits = 0;
+    for (int i = 0; i < 64; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+            _mm_and_si128(_mm_cmpgt_epi8(v, low), _mm_cmplt_epi8(v, high)));
+        bits |= static_cast<uint64_t>(_mm_movemask_epi8(ws)) << i;
+    }
+    return bits;
+#else
+    uint64_t bits = 0;
+    for (int i = 0; i < 64; i++) {
+        if (isSpace(p[i])) bits |= 1ULL << i;
+    }
+    return bits;
+#endif
+}
+
+size_t scanPoints(const char* begin, const char* end, long& pending,
+                  std::vector<Point>& points, bool& invalid) {
+    const char* p = begin;      // Start of the current token (or whitespace before it)
+    bool prevSpace = true;      // Whether the byte before the window is whitespace
+
+    for (const char* base = begin; pending > 0 && base < end; base += 64) {
+        uint64_t space = whitespaceBits(base, end);
+        // A token ends at each whitespace byte that follows a non-whitespace one
+        uint64_t ends = space & ~((space << 1) | (prevSpace ? 1 : 0));
+        prevSpace = (space >> 63) != 0;
+
+        while (ends && pending > 0) {
+            const char* stop = base + __builtin_ctzll(ends);
+            ends &= ends - 1;
+
+            // parsePoint skips the whitespace in front of the token itself
+            Point point;
+            if (parsePoint(p, stop, point)) {
+                points.push_back(point);
+            } else {
+                invalid = true;
+            }
+            pending--;
+            p = stop;
+        }
     }
-    return Point(0, 0);
+
+    // A token without a whitespace after it may continue in the next read
+    return p - begin;
+}
+
+// "ip:port" of a client, formatted once per connection for log lines
+void formatPeer(const struct sockaddr_in& addr, char* text, size_t size) {
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+    snprintf(text, size, "%s:%u", ip, static_cast<unsigned>(ntohs(addr.sin_port)));
 }
 
 // Send message to a specific client
 void sendToClient(int clientSocket, const std::string& message) {
     std::string msg = message + "\n";
-    send(clientSocket, msg.c_str(), msg.length(), 0);
+    ssize_t n = send(clientSocket, msg.c_str(), msg.length(), MSG_NOSIGNAL);
+    if (n > 0) countBytesOut(n);
 }
 
-// Process command from a client and return response
-std::string processCommand(const std::string& command) {
-    std::istringstream iss(command);
-    std::string cmd;
-    iss >> cmd;
-    
-    if (cmd == "Newgraph") {
-        int n;
-        iss >> n;
-        
-        // Lock mutex to protect shared graph
-        std::lock_guard<std::mutex> lock(graphMutex);
-
-        if (iss.fail()) {
-            return "Please specify a valid number of points.";
-        }
-        
-        // Clear the global graph and prepare for new points
-        globalGraph.clear();
-        globalGraph.reserve(n);
-        
-        counter = n; // Set counter for expected points
-        if (n <= 0) {
-            return "Invalid number of points. Please specify a positive integer.";
-        }
-        return "Ready for " + std::to_string(n) + " points. Send points one by one.";
-        
-    } else if (cmd == "CH") {
-        // Lock mutex to protect shared graph during algorithm execution
-        std::lock_guard<std::mutex> lock(graphMutex);
-        
-        // Calculate and return convex hull area
-        std::vector<Point> hull = convexHull(globalGraph);
-        double area = polygonArea(hull);
-        
+// Send everything buffered in output with as few send calls as the socket allows
+void flushOutput(int clientSocket, std::string& output) {
+    size_t sent = 0;
+    while (sent < output.size()) {
+        ssize_t n = send(clientSocket, output.data() + sent, output.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += n;
+    }
+    countBytesOut(sent);
+    output.clear(); // Keeps the capacity for the next batch
+}
+
+void appendInt(std::string& out, long long value) {
+    char text[24];
+    char* end = text + sizeof(text);
+    char* p = end;
+    unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : value;
+    do {
+        *--p = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) *--p = '-';
+    out.append(p, end - p);
+}
+
+static const double decimalScales[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+
+void appendFixed(std::string& out, double value, int decimals) {
+    double scaled = std::fabs(value) * (decimals >= 0 && decimals <= 6 ? decimalScales[decimals] : 0);
+    double whole = std::floor(scaled);
+    double fraction = scaled - whole;
+
+    // Large values, NaN/inf and near-ties need printf's exact rounding
+    if (decimals < 0 || decimals > 6 || !(scaled < 1e12) || std::fabs(fraction - 0.5) < 1e-3) {
+        char text[512];
+        int n = snprintf(text, sizeof(text), "%.*f", decimals, value);
+        if (n > 0) out.append(text, std::min(static_cast<size_t>(n), sizeof(text) - 1));
+        return;
+    }
+
+    uint64_t units = static_cast<uint64_t>(whole) + (fraction > 0.5 ? 1 : 0);
+    char text[32];
+    char* end = text + sizeof(text);
+    char* p = end;
+    for (int i = 0; i < decimals; i++) {
+        *--p = static_cast<char>('0' + units % 10);
+        units /= 10;
+    }
+    if (decimals > 0) *--p = '.';
+    do {
+        *--p = static_cast<char>('0' + units % 10);
+        units /= 10;
+    } while (units);
+    if (std::signbit(value)) *--p = '-';
+    out.append(p, end - p);
+}
+
+void appendPoint(std::string& out, const Point& point) {
+    out += '(';
+    appendFixed(out, point.x, 6);
+    out += ',';
+    appendFixed(out, point.y, 6);
+    out += ')';
+}
+
+// Append received bytes, dropping what earlier reads already consumed
+void appendInput(ClientInput& input, const char* data, size_t len) {
+    if (input.pos > 0) {
+        input.buffer.erase(0, input.pos);
+        input.pos = 0;
+    }
+    input.buffer.append(data, len);
+}
+
+// Take the next newline-terminated command off the input
+bool nextLine(ClientInput& input, std::string& line) {
+    size_t newline = input.buffer.find('\n', input.pos);
+    if (newline == std::string::npos) return false;
+
+    line.assign(input.buffer, input.pos, newline - input.pos);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    input.pos = newline + 1;
+    return true;
+}
+
+// Whether the unconsumed input is longer than any command line or payload point
+// may be; only meaningful once every complete line has been taken off
+bool lineTooLong(const ClientInput& input) {
+    return input.buffer.size() - input.pos > MAX_LINE_LENGTH;
+}
+
+// Parse "Loadpoints <n>"; the n points follow as one payload
+void startBulkLoad(ClientInput& input, const char* args, const char* end, std::string& out) {
+    long n;
+    if (!parseInteger(nextToken(args, end), n) || n <= 0) {
+        out += "Invalid number of points. Please specify a positive integer.";
+        return;
+    }
+    if (n > MAX_LOAD_POINTS) {
+        out += "Too many points for one Loadpoints (at most ";
+        appendInt(out, MAX_LOAD_POINTS);
+        out += ").";
+        return;
+    }
+
+    input.pendingPoints = n;
+    input.bulkStarted = statsNow();
+    input.bulkInvalid = false;
+    input.bulkPoints.clear();
+    // n is only the client's word: larger uploads grow as their points arrive
+    input.bulkPoints.reserve(std::min(n, static_cast<long>(LOAD_RESERVE_POINTS)));
+}
+
+// Parse the payload points received so far ("x,y" separated by whitespace)
+bool consumeBulkPoints(ClientInput& input) {
+    const char* data = input.buffer.data();
+    input.pos += scanPoints(data + input.pos, data + input.buffer.size(),
+                            input.pendingPoints, input.bulkPoints, input.bulkInvalid);
+    return input.pendingPoints == 0;
+}
+
+void finishBulkLoad(Graph& graph, ClientInput& input, std::string& out) {
+    if (input.bulkInvalid) {
+        std::vector<Point>().swap(input.bulkPoints);
+        out += "Invalid point format in Loadpoints payload. Graph unchanged.\n";
+        return;
+    }
+
+    size_t loaded = input.bulkPoints.size();
+    {
+        // One lock for the whole upload
+        std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+        graph.points.swap(input.bulkPoints);
+        graph.counter = 0;
+        graph.version++;
+        trackReplacedPoints(graph);
+    }
+
+    // Release the previous graph now held by the input
+    std::vector<Point>().swap(input.bulkPoints);
+    out += "Graph loaded with ";
+    appendInt(out, loaded);
+    out += " points.\n";
+}
+
+// Send a frame, retrying until the kernel took all of it
+void sendFrame(int clientSocket, const std::string& frame) {
+    size_t sent = 0;
+    while (sent < frame.size()) {
+        ssize_t n = send(clientSocket, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += n;
+    }
+    countBytesOut(sent);
+}
+
+std::shared_ptr<Graph> findGraph(const std::string& name, bool create) {
+    std::lock_guard<InstrumentedMutex> lock(graphsMutex);
+    auto it = graphs.find(name);
+    if (it != graphs.end()) return it->second;
+    if (!create || graphs.size() >= MAX_GRAPHS) return nullptr;
+    std::shared_ptr<Graph> graph = std::make_shared<Graph>();
+    graphs[name] = graph;
+    return graph;
+}
+
+bool validGraphName(const Token& name) {
+    size_t length = name.end - name.begin;
+    if (length == 0 || length > MAX_GRAPH_NAME) return false;
+    if (!((*name.begin >= 'a' && *name.begin <= 'z') || (*name.begin >= 'A' && *name.begin <= 'Z'))) return false;
+    for (const char* p = name.begin; p < name.end; p++) {
+        char c = *p;
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || isDigit(c) || c == '_' || c == '-')) return false;
+    }
+    return true;
+}
+
+// Whether p lies inside or on the counter-clockwise hull (3 or more vertices).
+// Binary search for the wedge around hull[0] that holds p: O(log h)
+bool insideHull(const std::vector<Point>& hull, const Point& p) {
+    size_t n = hull.size();
+    if (crossProduct(hull[0], hull[1], p) < 0 || crossProduct(hull[0], hull[n - 1], p) > 0) return false;
+
+    size_t lo = 1, hi = n - 1;
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if (crossProduct(hull[0], hull[mid], p) >= 0) lo = mid;
+        else hi = mid;
+    }
+    return crossProduct(hull[lo], hull[lo + 1], p) >= 0;
+}
+
+// Grows the counter-clockwise hull to take in p; false if p was already inside.
+// A point outside replaces the run of vertices it can see: O(h)
+bool extendHull(std::vector<Point>& hull, const Point& p) {
+    size_t n = hull.size();
+    if (n >= 3 && insideHull(hull, p)) return false;
+
+    // Edge i runs from hull[i] to hull[i + 1]; p sees it if it is not on its inner side
+    auto sees = [&](size_t i) { return crossProduct(hull[i], hull[(i + 1) % n], p) <= 0; };
+    size_t start = 0, steps = 0;
+    if (n >= 3) {
+        while (steps < n && !sees(start)) { start++; steps++; }
+        while (steps < n && sees((start + n - 1) % n)) { start = (start + n - 1) % n; steps++; }
+    }
+    if (n < 3 || steps == n) {
+        // Too few vertices for the walk (or rounding got in the way): rebuild from the vertices
+        hull.push_back(p);
+        hull = convexHull(std::move(hull));
+        return true;
+    }
+
+    size_t stop = start;
+    while (sees(stop)) stop = (stop + 1) % n;
+
+    // Vertices strictly inside the visible run go; p takes their place
+    std::vector<Point> grown;
+    grown.reserve(n + 1);
+    grown.push_back(p);
+    for (size_t i = stop; ; i = (i + 1) % n) {
+        grown.push_back(hull[i]);
+        if (i == start) break;
+    }
+    hull.swap(grown);
+    return true;
+}
+
+// Folds appended points into graph's cached hull; false if the hull did not change.
+// Gives up on the cache once the hull outgrows MAX_TRACKED_HULL
+static bool extendCachedHull(Graph& graph, const Point* points, size_t count) {
+    bool changed = false;
+    for (size_t i = 0; i < count; i++) {
+        changed |= extendHull(graph.hullVertices, points[i]);
+    }
+    graph.hullVersion = graph.version;
+    if (!changed) return false;
+
+    if (graph.hullVertices.size() > MAX_TRACKED_HULL) {
+        graph.hullCached = false;
+        std::vector<Point>().swap(graph.hullVertices);
+    } else {
+        graph.hull = measureHull(graph.hullVertices);
+    }
+    return true;
+}
+
+// Whether anyone listens for changes to graph's hull
+static bool hullWatched(const Graph& graph) {
+    return graph.watches.count > 0 || graph.feed.count > 0;
+}
+
+void trackAddedPoints(Graph& graph, const Point* points, size_t count) {
+    bool changed = true;
+    if (graph.hullCached && graph.hullVersion + 1 == graph.version) {
+        changed = extendCachedHull(graph, points, count);
+    }
+    if (changed && hullWatched(graph)) scheduleHullUpdate(graph);
+}
+
+void trackRemovedPoint(Graph& graph, const Point& point) {
+    graph.reshapedVersion = graph.version;
+    std::vector<Point>& hull = graph.hullVertices;
+    if (graph.hullCached && graph.hullVersion + 1 == graph.version &&
+        std::find(hull.begin(), hull.end(), point) == hull.end()) {
+        // Not a vertex, so the hull stays as it is
+        graph.hullVersion = graph.version;
+        return;
+    }
+    graph.hullCached = false;
+    hull.clear();
+    if (hullWatched(graph)) scheduleHullUpdate(graph);
+}
+
+void trackReplacedPoints(Graph& graph) {
+    graph.reshapedVersion = graph.version;
+    graph.hullVertices.clear();
+    graph.hullCached = graph.points.empty();
+    if (graph.hullCached) {
+        // Refilled point by point from here, each one extending the hull
+        graph.hullVersion = graph.version;
+        graph.hull = HullStats();
+    }
+    if (hullWatched(graph)) scheduleHullUpdate(graph);
+}
+
+bool cachedHull(Graph& graph, HullStats& stats, std::vector<Point>& snapshot, unsigned long& version) {
+    std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+    version = graph.version;
+    if (graph.hullCached && graph.hullVersion == graph.version) {
+        stats = graph.hull;
+        countHullCache(true);
+        return true;
+    }
+    uint64_t started = statsNow();
+    snapshot = graph.points;
+    recordHullPhase(HULL_COPY, statsNow() - started);
+    countHullCache(false);
+    return false;
+}
+
+void cacheHull(Graph& graph, unsigned long version, size_t pointCount,
+               std::vector<Point>& hull, const HullStats& stats) {
+    std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+    if (graph.hullCached && graph.hullVersion >= version) return; // Have one as new already
+    if (graph.reshapedVersion > version) return; // Points removed or replaced meanwhile
+
+    graph.hullCached = true;
+    graph.hullVersion = version;
+    graph.hull = stats;
+    graph.hullVertices.swap(hull);
+    // Catch up with the points appended while the hull was computed
+    if (graph.version != version) {
+        extendCachedHull(graph, graph.points.data() + pointCount, graph.points.size() - pointCount);
+    }
+}
+
+HullStats currentHull(Graph& graph) {
+    // Sort a copy outside the lock, so other clients are not held up meanwhile
+    HullStats stats;
+    std::vector<Point> snapshot;
+    unsigned long version;
+    if (cachedHull(graph, stats, snapshot, version)) return stats;
+
+    size_t pointCount = snapshot.size();
+    std::vector<Point> hull;
+    stats = timedHull(snapshot, hull);
+    publishHull(graph, version, stats, hull);
+    cacheHull(graph, version, pointCount, hull, stats);
+    return stats;
+}
+
+void publishCurrentHull(Graph& graph) {
+    HullStats stats;
+    std::vector<Point> snapshot, hull;
+    unsigned long version;
+    bool cached;
+    {
+        std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+        version = graph.version;
+        cached = graph.hullCached && graph.hullVersion == graph.version;
+        if (cached) {
+            stats = graph.hull;
+            hull = graph.hullVertices; // At most MAX_TRACKED_HULL vertices
+        } else {
+            uint64_t started = statsNow();
+            snapshot = graph.points;
+            recordHullPhase(HULL_COPY, statsNow() - started);
+        }
+    }
+    countHullCache(cached);
+    if (cached) {
+        publishHull(graph, version, stats, hull);
+        return;
+    }
+
+    size_t pointCount = snapshot.size();
+    stats = timedHull(snapshot, hull);
+    publishHull(graph, version, stats, hull);
+    cacheHull(graph, version, pointCount, hull, stats);
+}
+
+void publishHull(Graph& graph, unsigned long version, const HullStats& stats, const std::vector<Point>& hull) {
+    updateWatches(graph.watches, version, stats);
+    if (graph.feed.count > 0) updateHullFeed(graph.feed, version, hull);
+}
+
+// True once the client closed or reset the connection. A client that merely
+// closed sends a FIN, which only POLLRDHUP reports; pipelining clients end
+// with Bye instead, so a FIN means nobody waits for the reply
+static bool clientConnectionFailed(int clientSocket) {
+    struct pollfd pfd;
+    pfd.fd = clientSocket;
+    pfd.events = POLLRDHUP; // POLLERR and POLLHUP are always reported
+    pfd.revents = 0;
+    return poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLRDHUP | POLLERR | POLLHUP)) != 0;
+}
+
+bool hullShouldContinue(HullCancel& cancel) {
+    if (cancel.stopReason) return false;
+    if (cancel.cancelled.load(std::memory_order_relaxed)) {
+        cancel.stopReason = "cancelled";
+    } else if (cancel.hasDeadline && std::chrono::steady_clock::now() >= cancel.deadline) {
+        cancel.stopReason = "timed out";
+    } else if (cancel.clientSocket >= 0 && clientConnectionFailed(cancel.clientSocket)) {
+        cancel.stopReason = "abandoned by its client";
+    }
+    return cancel.stopReason == nullptr;
+}
+
+// Sorts blocks of HULL_CHECK_INTERVAL points, then merges them pairwise between
+// points and a second buffer, so no step runs long between two checkpoints
+static bool sortPoints(std::vector<Point>& points, HullCancel& cancel) {
+    size_t n = points.size();
+    cancel.phase = "sorting";
+    for (size_t i = 0; i < n; i += HULL_CHECK_INTERVAL) {
+        if (!hullShouldContinue(cancel)) return false;
+        size_t blockEnd = std::min(n, i + HULL_CHECK_INTERVAL);
+        std::sort(points.begin() + i, points.begin() + blockEnd);
+        cancel.workDone += blockEnd - i;
+    }
+    if (n <= HULL_CHECK_INTERVAL) return true;
+
+    std::vector<Point> buffer(n);
+    for (size_t width = HULL_CHECK_INTERVAL; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            const Point* a = points.data() + lo;
+            const Point* aEnd = points.data() + std::min(n, lo + width);
+            const Point* b = aEnd;
+            const Point* bEnd = points.data() + std::min(n, lo + 2 * width);
+            Point* out = buffer.data() + lo;
+            while (a < aEnd && b < bEnd) {
+                if (!hullShouldContinue(cancel)) return false;
+                size_t step = std::min<size_t>(HULL_CHECK_INTERVAL, std::min(aEnd - a, bEnd - b));
+                Point* stop = out + step;
+                while (out < stop) {
+                    if (*b < *a) *out++ = *b++;
+                    else *out++ = *a++;
+                }
+                cancel.workDone += step;
+            }
+            cancel.workDone += (aEnd - a) + (bEnd - b);
+            out = std::copy(a, aEnd, out);
+            std::copy(b, bEnd, out);
+        }
+        points.swap(buffer);
+    }
+    return true;
+}
+
+bool convexHull(std::vector<Point>& points, std::vector<Point>& hull, HullCancel& cancel) {
+    size_t n = points.size();
+    cancel.points = n;
+
+    // Every sorting pass and both hull scans touch each point once
+    size_t passes = 1;
+    for (size_t width = HULL_CHECK_INTERVAL; width < n; width *= 2) passes++;
+    cancel.workTotal = n * (passes + 2);
+    cancel.workDone = 0;
+
+    hull.clear();
+    if (n <= 1) {
+        hull = points;
+        return hullShouldContinue(cancel);
+    }
+    uint64_t started = statsNow();
+    if (!sortPoints(points, cancel)) return false;
+    uint64_t sorted = statsNow();
+    recordHullPhase(HULL_SORT, sorted - started);
+
+    // Same monotone chain as chainSortedPoints, with a checkpoint every block
+    cancel.phase = "building the hull";
+    for (size_t i = 0; i < n; i++) {
+        if (i % HULL_CHECK_INTERVAL == 0) {
+            if (!hullShouldContinue(cancel)) return false;
+            cancel.workDone += std::min<size_t>(HULL_CHECK_INTERVAL, n - i);
+        }
+        while (hull.size() >= 2 &&
+               crossProduct(hull[hull.size()-2], hull[hull.size()-1], points[i]) <= 0) {
+            hull.pop_back();
+        }
+        hull.push_back(points[i]);
+    }
+
+    size_t t = hull.size() + 1;
+    for (size_t i = n - 1; i-- > 0;) {
+        if (i % HULL_CHECK_INTERVAL == 0) {
+            if (!hullShouldContinue(cancel)) return false;
+            cancel.workDone += std::min<size_t>(HULL_CHECK_INTERVAL, i + 1);
+        }
+        while (hull.size() >= t &&
+               crossProduct(hull[hull.size()-2], hull[hull.size()-1], points[i]) <= 0) {
+            hull.pop_back();
+        }
+        hull.push_back(points[i]);
+    }
+
+    hull.pop_back();
+    recordHullPhase(HULL_SCAN, statsNow() - sorted);
+    return true;
+}
+
+void appendHullStopped(std::string& out, const HullCancel& cancel) {
+    auto elapsed = std::chrono::steady_clock::now() - cancel.started;
+    size_t percent = cancel.workTotal ? cancel.workDone * 100 / cancel.workTotal : 0;
+    out += cancel.stopReason;
+    out += " after ";
+    appendInt(out, std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+    out += " ms while ";
+    out += cancel.phase;
+    out += " (";
+    appendInt(out, percent < 100 ? percent : 99);
+    out += "% done, ";
+    appendInt(out, cancel.points);
+    out += " points)";
+}
+
+bool parseHullOptions(const char* args, const char* end, HullCancel& cancel) {
+    while (true) {
+        Token option = nextToken(args, end);
+        if (option.begin == option.end) return true;
+
+        // timeout=<n>ms, timeout=<n>s or timeout=<n> (milliseconds)
+        if (option.end - option.begin <= 8 || memcmp(option.begin, "timeout=", 8) != 0) return false;
+        Token number = {option.begin + 8, option.begin + 8};
+        while (number.end < option.end && isDigit(*number.end)) number.end++;
+
+        long amount;
+        if (!parseInteger(number, amount)) return false;
+        size_t unitLength = option.end - number.end;
+        long milliseconds;
+        if (unitLength == 0 || (unitLength == 2 && memcmp(number.end, "ms", 2) == 0)) {
+            milliseconds = amount;
+        } else if (unitLength == 1 && *number.end == 's') {
+            milliseconds = amount * 1000;
+        } else {
+            return false;
+        }
+        cancel.hasDeadline = true;
+        cancel.deadline = cancel.started + std::chrono::milliseconds(milliseconds);
+    }
+}
+
+// Sends as much of sink.pushed as the socket takes without blocking.
+// Call with sink.sendMutex held
+static void sendPushed(ClientSink& sink) {
+    size_t sent = 0;
+    while (sent < sink.pushed.size()) {
+        ssize_t n = send(sink.socket, sink.pushed.data() + sent, sink.pushed.size() - sent,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            sent += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            // The connection failed; its handler finds out from its next read
+            sent = sink.pushed.size();
+        }
+    }
+    countBytesOut(sent);
+    sink.pushed.erase(0, sent);
+}
+
+bool offerToClient(ClientSink& sink, const std::string& line, size_t maxBacklog) {
+    std::lock_guard<std::mutex> lock(sink.sendMutex);
+    if (!sink.open) return true; // Nobody left to resync
+    if (sink.pushed.size() > maxBacklog) return false;
+    bool waiting = !sink.pushed.empty();
+    sink.pushed += line;
+    // A busy handler sends it after its batch; a waiting backlog goes first
+    if (sink.busy || waiting) return true;
+    sendPushed(sink);
+    if (!sink.pushed.empty()) {
+        // The socket is full; the handler sends the rest as it drains
+        uint64_t one = 1;
+        ssize_t written = write(sink.wakeFd, &one, sizeof(one));
+        (void)written; // A counter already signalled wakes the handler as well
+    }
+    return true;
+}
+
+void pushToClient(ClientSink& sink, const std::string& line) {
+    // Hull results and watch transitions are never skipped, so the backlog
+    // is bounded by hanging up: the client reconnects and re-reads the state
+    if (offerToClient(sink, line, MAX_PUSH_BUFFER)) return;
+    std::lock_guard<std::mutex> lock(sink.sendMutex);
+    if (!sink.open) return;
+    logMessage(LOG_WARN, "Client stopped reading %zu pushed bytes, closing", sink.pushed.size());
+    std::string().swap(sink.pushed);
+    // The handler's next read fails, and it closes the socket as for any disconnect
+    shutdown(sink.socket, SHUT_RDWR);
+}
+
+bool waitForClient(ClientSink& sink) {
+    while (true) {
+        bool waiting;
         {
-            std::lock_guard<std::mutex> lock(chAreaMutex);
-            lastCHArea = area;
-            chAreaCond.notify_one();
-        }
-
-        std::ostringstream oss;
-        oss << std::fixed << std::setprecision(1) << area;
-        return "Convex Hull Area: " + oss.str();
-        
-    } else if (cmd == "Newpoint") {
-        // Add a new point to existing graph
-        std::string pointStr;
-        iss >> pointStr;
-        Point newPoint = parsePoint(pointStr);
-        
-        // Lock mutex to protect shared graph
-        std::lock_guard<std::mutex> lock(graphMutex);
-        globalGraph.push_back(newPoint);
-        
-        return "New point added: (" + std::to_string(newPoint.x) + "," + std::to_string(newPoint.y) + ")";
-        
-    } else if (cmd == "Removepoint") {
-        // Remove a point from the graph
-        std::string pointStr;
-        iss >> pointStr;
-        Point pointToRemove = parsePoint(pointStr);
-        
-        // Lock mutex to protect shared graph
-        std::lock_guard<std::mutex> lock(graphMutex);
-        
-        // Find and remove the point
-        auto it = std::find(globalGraph.begin(), globalGraph.end(), pointToRemove);
-        if (it != globalGraph.end()) {
-            globalGraph.erase(it);
-            return "Point removed: (" + std::to_string(pointToRemove.x) + "," + std::to_string(pointToRemove.y) + ")";
+            std::lock_guard<std::mutex> lock(sink.sendMutex);
+            waiting = !sink.pushed.empty();
+        }
+        // A push after this check signals wakeFd, so the poll returns for it
+        struct pollfd fds[2];
+        fds[0].fd = sink.socket;
+        fds[0].events = POLLIN | (waiting ? POLLOUT : 0);
+        fds[1].fd = sink.wakeFd;
+        fds[1].events = POLLIN;
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (fds[1].revents & POLLIN) {
+            uint64_t count;
+            ssize_t got = read(sink.wakeFd, &count, sizeof(count));
+            (void)got; // Only the wakeup matters
+        }
+        if (fds[0].revents & POLLOUT) {
+            std::lock_guard<std::mutex> lock(sink.sendMutex);
+            sendPushed(sink);
+        }
+        // Errors and hangups are for the handler's read to report
+        if (fds[0].revents & (POLLIN | POLLERR | POLLHUP)) return true;
+    }
+}
+
+// Execute one binary request and return the response frame
+std::string processBinaryFrame(Graph& graph, const BinaryFrame& frame) {
+    std::string payload;
+    std::vector<Point> points;
+
+    switch (frame.opcode & ~OP_FLOAT32) {
+    case OP_NEWGRAPH: {
+        if (!decodePoints(frame, points)) {
+            return encodeResponse(frame.opcode, STATUS_BAD_REQUEST, payload);
+        }
+        std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+        graph.points.swap(points);
+        graph.counter = 0;
+        graph.version++;
+        trackReplacedPoints(graph);
+        putU64(payload, graph.points.size());
+        break;
+    }
+    case OP_CH:
+        putF64(payload, currentHull(graph).area);
+        break;
+    case OP_NEWPOINT: {
+        if (!decodePoints(frame, points)) {
+            return encodeResponse(frame.opcode, STATUS_BAD_REQUEST, payload);
+        }
+        std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+        graph.points.insert(graph.points.end(), points.begin(), points.end());
+        graph.version++;
+        trackAddedPoints(graph, points.data(), points.size());
+        putU64(payload, graph.points.size());
+        break;
+    }
+    case OP_REMOVEPOINT: {
+        if (!decodePoints(frame, points) || points.size() != 1) {
+            return encodeResponse(frame.opcode, STATUS_BAD_REQUEST, payload);
+        }
+        std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+        auto it = std::find(graph.points.begin(), graph.points.end(), points[0]);
+        bool found = it != graph.points.end();
+        if (found) {
+            graph.points.erase(it);
+            graph.version++;
+            trackRemovedPoint(graph, points[0]);
+        }
+        putU64(payload, graph.points.size());
+        return encodeResponse(frame.opcode, found ? STATUS_OK : STATUS_NOT_FOUND, payload);
+    }
+    case OP_STATUS: {
+        std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+        putU64(payload, graph.points.size());
+        break;
+    }
+    default:
+        return encodeResponse(frame.opcode, STATUS_UNKNOWN_OPCODE, payload);
+    }
+    return encodeResponse(frame.opcode, STATUS_OK, payload);
+}
+
+// Answer every complete frame buffered; false if the client sent a malformed frame
+bool serveBinaryFrames(int clientSocket, Graph& graph, ClientInput& input) {
+    BinaryFrame frame;
+    int got;
+    while ((got = nextFrame(input.buffer, input.pos, frame)) > 0) {
+        uint64_t started = statsNow();
+        setStatsActivity(STAT_BINARY);
+        input.output += processBinaryFrame(graph, frame);
+        recordCommand(STAT_BINARY, statsNow() - started);
+    }
+    flushOutput(clientSocket, input.output);
+    return got == 0;
+}
+
+// Next whitespace-separated token at or after p; empty at the end of the line
+Token nextToken(const char*& p, const char* end) {
+    while (p < end && isSpace(*p)) p++;
+    Token token;
+    token.begin = p;
+    while (p < end && !isSpace(*p)) p++;
+    token.end = p;
+    return token;
+}
+
+// Parse a whole token as an integer of at most 9 digits
+bool parseInteger(const Token& token, long& value) {
+    const char* p = token.begin;
+    bool negative = p < token.end && *p == '-';
+    if (negative || (p < token.end && *p == '+')) p++;
+    if (p == token.end || token.end - p > 9) return false;
+
+    long v = 0;
+    for (; p < token.end; p++) {
+        if (!isDigit(*p)) return false;
+        v = v * 10 + (*p - '0');
+    }
+    value = negative ? -v : v;
+    return true;
+}
+
+static void appendTooManyGraphs(std::string& out) {
+    out += "Too many graphs (at most ";
+    appendInt(out, MAX_GRAPHS);
+    out += "). Please use an existing one.";
+}
+
+// Command handlers; [args, end) is the rest of the line after the command word.
+// Each appends its reply, without the newline, to out
+
+static void cmdNewgraph(ClientSession& session, const char* args, const char* end, std::string& out) {
+    // "Newgraph <n>" refills the current graph, "Newgraph <name> <n>" switches to name first
+    Token first = nextToken(args, end);
+    long n;
+    bool valid = parseInteger(first, n);
+    bool named = !valid && first.begin != first.end;
+    if (named) {
+        if (!validGraphName(first)) {
+            out += "Invalid graph name. Please use letters, digits, '_' or '-', starting with a letter.";
+            return;
+        }
+        valid = parseInteger(nextToken(args, end), n);
+    }
+    if (!valid) {
+        out += "Please specify a valid number of points.";
+        return;
+    }
+    if (named) {
+        std::string name(first.begin, first.end);
+        std::shared_ptr<Graph> found = findGraph(name, true);
+        if (!found) {
+            appendTooManyGraphs(out);
+            return;
+        }
+        session.graphName.swap(name);
+        session.graph = found;
+    }
+
+    // Lock mutex to protect shared graph
+    Graph& graph = *session.graph;
+    std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+
+    // Clear the graph and prepare for new points
+    graph.points.clear();
+    if (n > 0) graph.points.reserve(n);
+    graph.version++;
+    trackReplacedPoints(graph);
+
+    graph.counter = n; // Set counter for expected points
+    if (n <= 0) {
+        out += "Invalid number of points. Please specify a positive integer.";
+        return;
+    }
+    out += "Ready for ";
+    appendInt(out, n);
+    out += " points";
+    if (named) {
+        out += " in graph ";
+        out += session.graphName;
+    }
+    out += ". Send points one by one.";
+}
+
+static void cmdUse(ClientSession& session, const char* args, const char* end, std::string& out) {
+    Token name = nextToken(args, end);
+    if (!validGraphName(name)) {
+        out += "Invalid graph name. Please use 'Use <name>' with letters, digits, '_' or '-', starting with a letter.";
+        return;
+    }
+    std::string graphName(name.begin, name.end);
+    std::shared_ptr<Graph> graph = findGraph(graphName, true);
+    if (!graph) {
+        appendTooManyGraphs(out);
+        return;
+    }
+    session.graphName.swap(graphName);
+    session.graph = graph;
+
+    std::lock_guard<InstrumentedMutex> lock(session.graph->mutex);
+    out += "Using graph ";
+    out += session.graphName;
+    out += " (";
+    appendInt(out, session.graph->points.size());
+    out += " points)";
+}
+
+static void cmdCH(ClientSession& session, const char* args, const char* end, std::string& out) {
+    HullCancel cancel;
+    if (!parseHullOptions(args, end, cancel)) {
+        out += "Invalid option. Please use 'CH [timeout=<n>ms]'.";
+        return;
+    }
+    // Stop early if the client resets the connection meanwhile
+    cancel.clientSocket = session.sink->socket;
+
+    // Sort a copy outside the lock, so other clients are not held up meanwhile
+    Graph& graph = *session.graph;
+    HullStats stats;
+    std::vector<Point> points, hull;
+    unsigned long version;
+    if (cachedHull(graph, stats, points, version)) {
+        out += "Convex Hull Area: ";
+        appendFixed(out, stats.area, 1);
+        return;
+    }
+    if (!convexHull(points, hull, cancel)) {
+        size_t mark = out.size();
+        out += "CH ";
+        appendHullStopped(out, cancel);
+        logMessage(LOG_INFO, "%s", out.c_str() + mark);
+        return;
+    }
+
+    // Calculate and return convex hull area
+    stats = timedMeasureHull(hull);
+    publishHull(graph, version, stats, hull);
+    cacheHull(graph, version, points.size(), hull, stats);
+    out += "Convex Hull Area: ";
+    appendFixed(out, stats.area, 1);
+}
+
+static void cmdCHAsync(ClientSession& session, const char* args, const char* end, std::string& out) {
+    std::shared_ptr<HullCancel> cancel = std::make_shared<HullCancel>();
+    if (!parseHullOptions(args, end, *cancel)) {
+        out += "Invalid option. Please use 'CHAsync [timeout=<n>ms]'.";
+        return;
+    }
+
+    unsigned long ticket;
+    {
+        std::lock_guard<InstrumentedMutex> lock(ticketsMutex);
+        // Every job holds a copy of its graph, so both limits bound memory as well as workers
+        std::vector<unsigned long>& running = session.hullTickets;
+        running.erase(std::remove_if(running.begin(), running.end(), [](unsigned long t) {
+            auto it = hullTickets.find(t);
+            return it == hullTickets.end() || it->second.done;
+        }), running.end());
+        if (running.size() >= MAX_SESSION_HULLS) {
+            out += "Busy: at most ";
+            appendInt(out, MAX_SESSION_HULLS);
+            out += " CHAsync hulls may run per connection; wait for one or stop it with 'CHCancel <ticket>'.";
+            return;
+        }
+        if (runningHulls >= MAX_RUNNING_HULLS) {
+            out += "Busy: the server is running too many hulls. Please retry later.";
+            return;
+        }
+        ticket = nextTicket++;
+        HullTicket& entry = hullTickets[ticket];
+        entry.cancel = cancel;
+        entry.owner = session.sink;
+        running.push_back(ticket);
+        runningHulls++;
+    }
+
+    // The hull runs on a copy, so the graph stays free for other clients meanwhile
+    std::shared_ptr<std::vector<Point>> snapshot = std::make_shared<std::vector<Point>>();
+    HullStats cachedStats;
+    unsigned long version;
+    bool cached = cachedHull(*session.graph, cachedStats, *snapshot, version);
+
+    std::shared_ptr<ClientSink> sink = session.sink;
+    std::shared_ptr<Graph> graph = session.graph;
+    hullPool->submit([sink, graph, snapshot, cancel, ticket, cached, cachedStats, version]() {
+        // A job cancelled or expired while queued gives its worker back at once
+        std::vector<Point> hull;
+        std::string line = "CH ticket ";
+        appendInt(line, ticket);
+        if (cached) {
+            line += " done. Convex Hull Area: ";
+            appendFixed(line, cachedStats.area, 1);
+        } else if (hullShouldContinue(*cancel) && convexHull(*snapshot, hull, *cancel)) {
+            HullStats stats = timedMeasureHull(hull);
+            publishHull(*graph, version, stats, hull);
+            cacheHull(*graph, version, snapshot->size(), hull, stats);
+            line += " done. Convex Hull Area: ";
+            appendFixed(line, stats.area, 1);
         } else {
-            return "Point not found: (" + std::to_string(pointToRemove.x) + "," + std::to_string(pointToRemove.y) + ")";
-        }
-        
-    } else if (cmd == "Status") {
-        // Lock mutex to protect shared graph
-        std::lock_guard<std::mutex> lock(graphMutex);
-        
-        // Return current graph status
-        return "Current graph has " + std::to_string(globalGraph.size()) + " points";
-        
-    } else {
-        // Lock mutex to protect counter and graph access
-        std::lock_guard<std::mutex> lock(graphMutex);
-        
-        if (counter > 0){        
-            try {
-                Point newPoint = parsePoint(command);
-                globalGraph.push_back(newPoint);
-                counter--;
-                return "Point added: (" + std::to_string(newPoint.x) + "," + std::to_string(newPoint.y) + ")";
-            } catch (...) {
-                return "Unknown command or invalid point format. Please use one of the following commands:\n"
-                    "Newgraph <n>, <x,y>, CH, Newpoint <x,y>, Removepoint <x,y>, Status";
+            line += ' ';
+            appendHullStopped(line, *cancel);
+        }
+        std::vector<Point>().swap(*snapshot);
+
+        {
+            std::lock_guard<InstrumentedMutex> lock(ticketsMutex);
+            runningHulls--;
+            auto it = hullTickets.find(ticket);
+            if (it != hullTickets.end()) {
+                it->second.done = true;
+                it->second.result = line;
+                it->second.cancel.reset();
+            }
+            finishedTickets.push_back(ticket);
+            if (finishedTickets.size() > MAX_FINISHED_TICKETS) {
+                hullTickets.erase(finishedTickets.front());
+                finishedTickets.pop_front();
             }
+        }
+
+        // Push the result unless the client is gone; CHResult can still fetch it
+        line += '\n';
+        pushToClient(*sink, line);
+    });
+
+    // Pushes wait for this batch's replies, so the ticket always precedes its result
+    out += "CH ticket ";
+    appendInt(out, ticket);
+    out += " started";
+}
+
+// The session's own ticket, or nullptr; ticket numbers are easy to guess, so
+// other connections' tickets look unknown. Call with ticketsMutex held
+static HullTicket* findTicket(ClientSession& session, long ticket) {
+    auto it = hullTickets.find(ticket);
+    if (it == hullTickets.end()) return nullptr;
+    const std::weak_ptr<ClientSink>& owner = it->second.owner;
+    // Compares the sinks themselves, so a later sink at the same address never matches
+    if (owner.owner_before(session.sink) || session.sink.owner_before(owner)) return nullptr;
+    return &it->second;
+}
+
+static void cmdCHCancel(ClientSession& session, const char* args, const char* end, std::string& out) {
+    long ticket;
+    if (!parseInteger(nextToken(args, end), ticket) || ticket <= 0) {
+        out += "Invalid ticket. Please use 'CHCancel <ticket>'.";
+        return;
+    }
+
+    std::lock_guard<InstrumentedMutex> lock(ticketsMutex);
+    HullTicket* entry = findTicket(session, ticket);
+    if (!entry) {
+        out += "Unknown CH ticket ";
+        appendInt(out, ticket);
+        return;
+    }
+    out += "CH ticket ";
+    appendInt(out, ticket);
+    if (entry->done) {
+        out += " already finished";
+    } else {
+        // The worker notices at its next checkpoint and pushes the cancelled result
+        entry->cancel->cancelled = true;
+        out += " cancelling";
+    }
+}
+
+static void cmdNewpoint(ClientSession& session, const char* args, const char* end, std::string& out) {
+    // Add a new point to existing graph
+    Token pointArg = nextToken(args, end);
+    Point newPoint;
+    if (!parsePoint(pointArg.begin, pointArg.end, newPoint)) {
+        out += "Invalid point format. Please use 'Newpoint <x,y>'.";
+        return;
+    }
+
+    // Lock mutex to protect shared graph
+    Graph& graph = *session.graph;
+    std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+
+    graph.points.push_back(newPoint);
+    graph.version++;
+    trackAddedPoints(graph, &newPoint, 1);
+    out += "New point added: ";
+    appendPoint(out, newPoint);
+}
+
+static void cmdRemovepoint(ClientSession& session, const char* args, const char* end, std::string& out) {
+    // Remove a point from the graph
+    Token pointArg = nextToken(args, end);
+    Point pointToRemove;
+    if (!parsePoint(pointArg.begin, pointArg.end, pointToRemove)) {
+        out += "Invalid point format. Please use 'Removepoint <x,y>'.";
+        return;
+    }
+
+    // Lock mutex to protect shared graph
+    Graph& graph = *session.graph;
+    std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+
+    // Find and remove the point
+    auto it = std::find(graph.points.begin(), graph.points.end(), pointToRemove);
+    if (it != graph.points.end()) {
+        graph.points.erase(it);
+        graph.version++;
+        trackRemovedPoint(graph, pointToRemove);
+        out += "Point removed: ";
+    } else {
+        out += "Point not found: ";
+    }
+    appendPoint(out, pointToRemove);
+}
+
+static void cmdCHResult(ClientSession& session, const char* args, const char* end, std::string& out) {
+    long ticket;
+    if (!parseInteger(nextToken(args, end), ticket) || ticket <= 0) {
+        out += "Invalid ticket. Please use 'CHResult <ticket>'.";
+        return;
+    }
+
+    std::lock_guard<InstrumentedMutex> lock(ticketsMutex);
+    HullTicket* entry = findTicket(session, ticket);
+    if (!entry) {
+        out += "Unknown CH ticket ";
+        appendInt(out, ticket);
+    } else if (!entry->done) {
+        out += "CH ticket ";
+        appendInt(out, ticket);
+        out += " still computing";
+    } else {
+        out += entry->result;
+    }
+}
+
+static void cmdWatch(ClientSession& session, const char* args, const char* end, std::string& out) {
+    static std::atomic<unsigned long> nextWatchId{1};
+
+    std::shared_ptr<Watch> watch = std::make_shared<Watch>();
+    if (!parseWatch(args, end, *watch)) {
+        out += "Invalid watch. Please use 'Watch <area|perimeter|vertices> <>=|<> <value>'.";
+        return;
+    }
+    if (session.watches.size() >= MAX_SESSION_WATCHES) {
+        out += "Too many watches; remove one with 'Unwatch <id>' first.";
+        return;
+    }
+    watch->id = nextWatchId++;
+    watch->sink = session.sink;
+
+    // The watch starts from the watches' stats, and with nothing watching the
+    // cached hull moves on without them: publish it first
+    Graph& graph = *session.graph;
+    publishCurrentHull(graph);
+    unsigned long version = addWatch(graph.watches, watch);
+    {
+        // A change in between found nothing to notify; catch up with it as a notification
+        std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+        if (version != graph.version) scheduleHullUpdate(graph);
+    }
+    session.watches.push_back(std::make_pair(session.graph, watch));
+
+    out += "Watch ";
+    appendInt(out, watch->id);
+    out += " on graph ";
+    out += session.graphName;
+    out += ": ";
+    appendWatchPredicate(out, *watch);
+    out += watch->state ? " (currently true)" : " (currently false)";
+}
+
+static void cmdUnwatch(ClientSession& session, const char* args, const char* end, std::string& out) {
+    long id;
+    if (!parseInteger(nextToken(args, end), id) || id <= 0) {
+        out += "Invalid watch. Please use 'Unwatch <id>'.";
+        return;
+    }
+
+    for (auto it = session.watches.begin(); it != session.watches.end(); ++it) {
+        if (it->second->id != static_cast<unsigned long>(id)) continue;
+        removeWatch(it->first->watches, it->second);
+        session.watches.erase(it);
+        out += "Watch ";
+        appendInt(out, id);
+        out += " removed";
+        return;
+    }
+    // Other connections' watches are not this one's to remove
+    out += "Unknown watch ";
+    appendInt(out, id);
+}
+
+static void cmdSubscribe(ClientSession& session, const char* args, const char* end, std::string& out) {
+    static std::atomic<unsigned long> nextSubscriptionId{1};
+
+    Token what = nextToken(args, end);
+    if (what.end - what.begin != 4 || memcmp(what.begin, "hull", 4) != 0 || nextToken(args, end).begin != end) {
+        out += "Invalid subscription. Please use 'Subscribe hull'.";
+        return;
+    }
+
+    // One subscription per graph; subscribing again resends the snapshot
+    std::shared_ptr<HullSubscription> subscription;
+    for (auto& registration : session.subscriptions) {
+        if (registration.first == session.graph) subscription = registration.second;
+    }
+    if (!subscription) {
+        subscription = std::make_shared<HullSubscription>();
+        subscription->id = nextSubscriptionId++;
+        subscription->sink = session.sink;
+        session.subscriptions.push_back(std::make_pair(session.graph, subscription));
+    }
+    subscribeHull(session.graph->feed, subscription, out);
+
+    // The snapshot may predate the graph's cached hull; any difference follows as a change
+    publishCurrentHull(*session.graph);
+}
+
+static void cmdUnsubscribe(ClientSession& session, const char* args, const char* end, std::string& out) {
+    Token what = nextToken(args, end);
+    if (what.end - what.begin != 4 || memcmp(what.begin, "hull", 4) != 0 || nextToken(args, end).begin != end) {
+        out += "Invalid subscription. Please use 'Unsubscribe hull'.";
+        return;
+    }
+
+    for (auto it = session.subscriptions.begin(); it != session.subscriptions.end(); ++it) {
+        if (it->first != session.graph) continue;
+        unsubscribeHull(it->first->feed, it->second);
+        out += "Hull ";
+        appendInt(out, it->second->id);
+        out += " unsubscribed";
+        session.subscriptions.erase(it);
+        return;
+    }
+    out += "Not subscribed to graph ";
+    out += session.graphName;
+}
+
+static void cmdStatus(ClientSession& session, const char*, const char*, std::string& out) {
+    // Lock mutex to protect shared graph
+    std::lock_guard<InstrumentedMutex> lock(session.graph->mutex);
+
+    // Return current graph status
+    out += "Current graph has ";
+    appendInt(out, session.graph->points.size());
+    out += " points";
+}
+
+static void appendStats(std::string& out);
+
+// The pipelined client's last command: the connection closes once every reply
+// before this one is out. Shutting down the write side instead would read as
+// a client that gave up, and stop any hull still being computed for it
+static void cmdBye(ClientSession& session, const char*, const char*, std::string& out) {
+    out += "Bye";
+    session.closing = true;
+}
+
+static void cmdStats(ClientSession&, const char*, const char*, std::string& out) {
+    appendStats(out);
+}
+
+// The payload that follows is read by the input loop; nothing to reply until it is in
+static void cmdLoadpoints(ClientSession& session, const char* args, const char* end, std::string& out) {
+    startBulkLoad(session.input, args, end, out);
+}
+
+#define COMMAND(name, handler) { name, sizeof(name) - 1, handler }
+
+// Every text command; adding one is a new row here
+static constexpr CommandEntry commandTable[] = {
+    COMMAND("Newgraph", cmdNewgraph),
+    COMMAND("CH", cmdCH),
+    COMMAND("Newpoint", cmdNewpoint),
+    COMMAND("Removepoint", cmdRemovepoint),
+    COMMAND("Status", cmdStatus),
+    COMMAND("CHAsync", cmdCHAsync),
+    COMMAND("CHResult", cmdCHResult),
+    COMMAND("CHCancel", cmdCHCancel),
+    COMMAND("Use", cmdUse),
+    COMMAND("Watch", cmdWatch),
+    COMMAND("Unwatch", cmdUnwatch),
+    COMMAND("Subscribe", cmdSubscribe),
+    COMMAND("Unsubscribe", cmdUnsubscribe),
+    COMMAND("Stats", cmdStats),
+    COMMAND("Bye", cmdBye),
+    COMMAND("Loadpoints", cmdLoadpoints)
+};
+
+static constexpr size_t commandCount = sizeof(commandTable) / sizeof(commandTable[0]);
+
+#define COMMAND_SLOTS 64
+
+// Dispatch slot of a command word, from its length and first and last characters
+static constexpr unsigned commandSlot(const char* word, size_t length) {
+    return (length * 5 + static_cast<unsigned char>(word[0]) +
+            static_cast<unsigned char>(word[length - 1]) * 2) % COMMAND_SLOTS;
+}
+
+// Index of the command in slot, or -1
+static constexpr int commandInSlot(unsigned slot, size_t i = 0) {
+    return i == commandCount ? -1
+         : commandSlot(commandTable[i].name, commandTable[i].length) == slot ? static_cast<int>(i)
+         : commandInSlot(slot, i + 1);
+}
+
+// True if every command has a slot of its own
+static constexpr bool slotsDistinct(size_t i = 0) {
+    return i == commandCount ||
+           (commandInSlot(commandSlot(commandTable[i].name, commandTable[i].length)) == static_cast<int>(i) &&
+            slotsDistinct(i + 1));
+}
+
+static_assert(slotsDistinct(), "Two commands share a dispatch slot; change commandSlot");
+
+#define SLOT_ROW(n) commandInSlot(n), commandInSlot(n + 1), commandInSlot(n + 2), commandInSlot(n + 3), \
+                    commandInSlot(n + 4), commandInSlot(n + 5), commandInSlot(n + 6), commandInSlot(n + 7)
+
+// Slot -> commandTable index, computed by the compiler
+static constexpr signed char commandSlots[COMMAND_SLOTS] = {
+    SLOT_ROW(0), SLOT_ROW(8), SLOT_ROW(16), SLOT_ROW(24),
+    SLOT_ROW(32), SLOT_ROW(40), SLOT_ROW(48), SLOT_ROW(56)
+};
+
+const CommandEntry* findCommand(const char* word, size_t length) {
+    if (length == 0) return nullptr;
+    int index = commandSlots[commandSlot(word, length)];
+    if (index < 0) return nullptr;
+
+    const CommandEntry& entry = commandTable[index];
+    if (entry.length != length || memcmp(entry.name, word, length) != 0) return nullptr;
+    return &entry;
+}
+
+#define STAT_SLOTS_USED (STAT_COMMANDS + commandCount)
+
+static_assert(STAT_SLOTS_USED <= STAT_SLOTS, "Raise STAT_SLOTS for the new commands");
+
+static const char* statName(int slot) {
+    switch (slot) {
+    case STAT_POINT: return "<x,y>";
+    case STAT_LOADPOINTS: return "Loadpoints upload";
+    case STAT_BINARY: return "binary frame";
+    case STAT_UNKNOWN: return "unknown";
+    case STAT_BACKGROUND: return "background";
+    default: return commandTable[slot - STAT_COMMANDS].name;
+    }
+}
+
+#define MAX_STATS_GRAPHS 16 // Graphs listed by Stats; the rest are only counted
+
+static void appendLatency(std::string& out, const char* label, const LatencySummary& latency) {
+    static const double percentiles[] = {50, 90, 99, 99.9};
+    static const char* const percentileNames[] = {"p50", "p90", "p99", "p99.9"};
+    out += label;
+    out += ": ";
+    appendInt(out, latency.count);
+    for (int i = 0; i < 4; i++) {
+        out += ", ";
+        out += percentileNames[i];
+        out += ' ';
+        appendFixed(out, latency.percentile(percentiles[i]) / 1000.0, 1);
+    }
+    out += ", max ";
+    appendFixed(out, latency.max / 1000.0, 1);
+    out += " us";
+}
+
+#define TOP_LOCK_USERS 3 // Activities listed per lock class
+
+// ", CH 12.345 ms, Newpoint 1.234 ms" for the activities with the most time in byActivity
+static void appendTopActivities(std::string& out, const uint64_t* byActivity) {
+    std::vector<int> slots;
+    for (int slot = 0; slot <= STAT_BACKGROUND; slot++) {
+        if (byActivity[slot] > 0) slots.push_back(slot);
+    }
+    std::sort(slots.begin(), slots.end(), [byActivity](int a, int b) { return byActivity[a] > byActivity[b]; });
+    if (slots.empty()) out += " none";
+    for (size_t i = 0; i < slots.size() && i < TOP_LOCK_USERS; i++) {
+        out += i ? ", " : " ";
+        out += statName(slots[i]);
+        out += ' ';
+        appendFixed(out, byActivity[slots[i]] / 1e6, 3);
+        out += " ms";
+    }
+}
+
+// Counters of the whole server, one item per line (no newline after the last).
+// The first line says how many follow, so a client knows where the reply ends
+static void appendStats(std::string& out) {
+    std::unique_ptr<ServerStats> stats(new ServerStats());
+    collectStats(*stats);
+
+    std::vector<std::pair<std::string, std::shared_ptr<Graph>>> listed;
+    size_t graphCount;
+    {
+        std::lock_guard<InstrumentedMutex> lock(graphsMutex);
+        graphCount = graphs.size();
+        for (auto it = graphs.begin(); it != graphs.end() && listed.size() < MAX_STATS_GRAPHS; ++it) {
+            listed.push_back(*it);
+        }
+    }
+
+    std::string body;
+    int lines = 0;
+    body += "\nconnections: ";
+    appendInt(body, stats->connectionsOpened - stats->connectionsClosed);
+    body += " open, ";
+    appendInt(body, stats->connectionsOpened);
+    body += " since start; bytes in ";
+    appendInt(body, stats->bytesIn);
+    body += ", out ";
+    appendInt(body, stats->bytesOut);
+    lines++;
+
+    uint64_t lookups = stats->cacheHits + stats->cacheMisses;
+    body += "\nhull cache: ";
+    appendInt(body, stats->cacheHits);
+    body += " hits, ";
+    appendInt(body, stats->cacheMisses);
+    body += " misses (";
+    appendFixed(body, lookups ? 100.0 * stats->cacheHits / lookups : 0.0, 1);
+    body += "% hit rate)";
+    lines++;
+
+    for (auto& named : listed) {
+        Graph& graph = *named.second;
+        std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+        body += "\ngraph ";
+        body += named.first;
+        body += ": ";
+        appendInt(body, graph.points.size());
+        if (graph.hullCached && graph.hullVersion == graph.version) {
+            body += " points, hull ";
+            appendInt(body, graph.hull.vertices);
+            body += " vertices";
         } else {
-            return "The graph is full. Please start a new graph with 'Newgraph <n>' command or add new points with 'Newpoint <x,y>'.";
+            body += " points, hull not computed since the last change";
         }
+        lines++;
     }
+    if (graphCount > listed.size()) {
+        body += "\n";
+        appendInt(body, graphCount - listed.size());
+        body += " more graphs";
+        lines++;
+    }
+
+    // Latencies in microseconds, from the command line parsed to its reply formatted
+    for (int slot = 0; slot < static_cast<int>(STAT_SLOTS_USED); slot++) {
+        if (stats->commands[slot].count == 0) continue;
+        body += '\n';
+        std::string label = "command ";
+        label += statName(slot);
+        appendLatency(body, label.c_str(), stats->commands[slot]);
+        lines++;
+    }
+    for (int phase = 0; phase < HULL_PHASE_COUNT; phase++) {
+        if (stats->hullPhases[phase].count == 0) continue;
+        body += '\n';
+        std::string label = "hull ";
+        label += hullPhaseNames[phase];
+        appendLatency(body, label.c_str(), stats->hullPhases[phase]);
+        lines++;
+    }
+
+    // Lock waits and holds: how much of a command's latency was queueing rather than work
+    for (int lockClass = 0; lockClass < LOCK_CLASS_COUNT; lockClass++) {
+        const LockSummary& lock = stats->locks[lockClass];
+        if (lock.hold.count == 0) continue;
+        std::string label = "lock ";
+        label += lockClassNames[lockClass];
+        body += '\n';
+        body += label;
+        body += ": ";
+        appendInt(body, lock.hold.count);
+        body += " acquired, ";
+        appendInt(body, lock.contended);
+        body += " contended (";
+        appendFixed(body, 100.0 * lock.contended / lock.hold.count, 1);
+        body += "%); held longest by";
+        appendTopActivities(body, lock.heldBy);
+        body += "; waited longest in";
+        appendTopActivities(body, lock.waitedBy);
+        body += '\n';
+        appendLatency(body, (label + " wait").c_str(), lock.wait);
+        body += '\n';
+        appendLatency(body, (label + " hold").c_str(), lock.hold);
+        lines += 3;
+    }
+
+    out += "Stats: ";
+    appendInt(out, lines);
+    out += " lines follow";
+    out += body;
+}
+
+// Process command from a client and append the response line to out
+void processCommand(ClientSession& session, const std::string& command, std::string& out) {
+    uint64_t started = statsNow();
+    // While a graph is being filled nearly every line is a point; skip the tokenizer for those
+    setStatsActivity(STAT_POINT);
+    Point newPoint;
+    Graph& graph = *session.graph;
+    if (parsePoint(command, newPoint)) {
+        std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+        if (graph.counter > 0) {
+            graph.points.push_back(newPoint);
+            graph.counter--;
+            graph.version++;
+            trackAddedPoints(graph, &newPoint, 1);
+            out += "Point added: ";
+            appendPoint(out, newPoint);
+            out += '\n';
+            recordCommand(STAT_POINT, statsNow() - started);
+            return;
+        }
+    }
+
+    const char* p = command.data();
+    const char* end = p + command.size();
+    Token cmd = nextToken(p, end);
+    const CommandEntry* entry = findCommand(cmd.begin, cmd.end - cmd.begin);
+    if (entry) {
+        setStatsActivity(STAT_COMMANDS + (entry - commandTable));
+        size_t mark = out.size();
+        entry->handler(session, p, end, out);
+        if (out.size() != mark) out += '\n'; // Loadpoints replies once its payload is in
+        recordCommand(STAT_COMMANDS + (entry - commandTable), statsNow() - started);
+        return;
+    }
+
+    // Lock mutex to protect counter and graph access
+    setStatsActivity(STAT_UNKNOWN);
+    std::lock_guard<InstrumentedMutex> lock(graph.mutex);
+
+    if (graph.counter > 0){
+        out += "Unknown command or invalid point format. Please use one of the following commands:\n"
+            "Use <name>, Newgraph [<name>] <n>, <x,y>, Loadpoints <n>, CH [timeout=<n>ms], CHAsync [timeout=<n>ms], CHResult <ticket>, CHCancel <ticket>, Watch <metric> <op> <value>, Unwatch <id>, Subscribe hull, Unsubscribe hull, Newpoint <x,y>, Removepoint <x,y>, Status, Stats, Bye\n";
+    } else {
+        out += "The graph is full. Please start a new graph with 'Newgraph <n>' command or add new points with 'Newpoint <x,y>'.\n";
+    }
+    recordCommand(STAT_UNKNOWN, statsNow() - started);
 }
 
 // Handle client connection in a separate thread
@@ -238,59 +1778,150 @@ void* handleClient(int clientSocket) {
     socklen_t addrLen = sizeof(clientAddr);
     getpeername(clientSocket, (struct sockaddr*)&clientAddr, &addrLen);
 
-    std::cout << "Client handler thread started for " << inet_ntoa(clientAddr.sin_addr) 
-              << ":" << ntohs(clientAddr.sin_port) << std::endl;
+    // The sink is shared with CHAsync jobs, which may outlive this thread
+    ClientSession session;
+    ClientInput& input = session.input;
+    session.sink = std::make_shared<ClientSink>();
+    ClientSink& sink = *session.sink;
+    sink.socket = clientSocket;
+    sink.wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (sink.wakeFd < 0) {
+        logMessage(LOG_ERROR, "eventfd failed: %s", strerror(errno));
+        close(clientSocket);
+        return nullptr;
+    }
+    session.graphName = DEFAULT_GRAPH;
+    session.graph = findGraph(session.graphName, true);
+
+    char peer[PEER_NAME_SIZE];
+    formatPeer(clientAddr, peer, sizeof(peer));
+    logMessage(LOG_INFO, "Client handler thread started for %s", peer);
+    countConnection(true);
 
-    sendToClient(clientSocket, "Commands: Newgraph <n>, <x,y>, CH, Newpoint <x,y>, Removepoint <x,y>, Status");
+    sendToClient(clientSocket, "Commands: Use <name>, Newgraph [<name>] <n>, <x,y>, Loadpoints <n>, CH [timeout=<n>ms], CHAsync [timeout=<n>ms], CHResult <ticket>, CHCancel <ticket>, Watch <metric> <op> <value>, Unwatch <id>, Subscribe hull, Unsubscribe hull, Newpoint <x,y>, Removepoint <x,y>, Status, Stats, Bye");
     
     while (true) {
-        valread = read(clientSocket, buffer, BUFSIZE - 1);
+        valread = waitForClient(sink) ? read(clientSocket, buffer, BUFSIZE) : -1;
         if (valread <= 0) {
-            std::cout << "Client disconnected: " << inet_ntoa(clientAddr.sin_addr) 
-                      << ":" << ntohs(clientAddr.sin_port) << std::endl;
+            logMessage(LOG_INFO, "Client disconnected: %s", peer);
             break;
         }
-        buffer[valread] = '\0';
-        std::string command(buffer);
-        if (!command.empty() && command.back() == '\n') command.pop_back();
-        if (!command.empty() && command.back() == '\r') command.pop_back();
+        countBytesIn(valread);
+        try {
+            appendInput(input, buffer, valread);
 
-        std::cout << "Received command from " << inet_ntoa(clientAddr.sin_addr) 
-                  << ": " << command << std::endl;
+            // A binary client announces itself with the magic as its first bytes
+            if (!input.negotiated) {
+                ProtocolDetect mode = detectProtocol(input.buffer.data() + input.pos, input.buffer.size() - input.pos);
+                if (mode == DETECT_NEED_MORE) continue;
+                input.negotiated = true;
+                if (mode == DETECT_BINARY) {
+                    input.binary = true;
+                    input.pos += BINARY_MAGIC_LEN;
+                    sendFrame(clientSocket, encodeResponse(OP_HELLO, STATUS_OK, ""));
+                    logMessage(LOG_INFO, "Client %s switched to the binary protocol", peer);
+                }
+            }
+            if (input.binary) {
+                if (!serveBinaryFrames(clientSocket, *session.graph, input)) {
+                    logMessage(LOG_WARN, "Malformed frame from %s, closing", peer);
+                    break;
+                }
+                continue;
+            }
 
-        std::string response = processCommand(command);
-        sendToClient(clientSocket, response);
+            // Run every complete command received so far; pushes wait until its replies are out
+            {
+                std::lock_guard<std::mutex> lock(sink.sendMutex);
+                sink.busy = true;
+            }
+            std::string command;
+            std::string& out = input.output;
+            while (!session.closing) {
+                size_t mark = out.size();
+                if (input.pendingPoints > 0) {
+                    // Loadpoints payload: a single reply once the last point is in
+                    if (!consumeBulkPoints(input)) break;
+                    setStatsActivity(STAT_LOADPOINTS);
+                    finishBulkLoad(*session.graph, input, out);
+                    recordCommand(STAT_LOADPOINTS, statsNow() - input.bulkStarted);
+                } else {
+                    if (!nextLine(input, command)) break;
+                    if (command.empty()) continue;
 
-        std::cout << "Sent response to " << inet_ntoa(clientAddr.sin_addr) 
-                  << ": " << response << std::endl;
-    }
-    close(clientSocket);
-    std::cout << "Client handler thread ending for " << inet_ntoa(clientAddr.sin_addr) 
-              << ":" << ntohs(clientAddr.sin_port) << std::endl;
-    return nullptr;
-}
+                    logMessage(LOG_DEBUG, "Received command from %s: %s", peer, command.c_str());
+
+                    processCommand(session, command, out);
+                }
+                if (out.size() == mark) continue;
 
-// Watcher thread to monitor CH area
-// and notify when it reaches or drops below 100 units
-void* chAreaWatcherThread(void*) {
-    bool lastState = false;
-    while (watcherRunning) {
-        std::unique_lock<std::mutex> lock(chAreaMutex);
-        chAreaCond.wait(lock); // Wait for notification
+                logMessage(LOG_DEBUG, "Sent response to %s: %.*s", peer,
+                           static_cast<int>(out.size() - mark - 1), out.data() + mark);
+            }
 
-        bool nowAtLeast100 = (lastCHArea >= 100.0);
-        if (nowAtLeast100 && !lastState) {
-            std::cout << "At Least 100 units belongs to CH" << std::endl;
-        } else if (!nowAtLeast100 && lastState) {
-            std::cout << "At Least 100 units no longer belongs to CH" << std::endl;
+            // A client that never ends its line would otherwise grow the buffer without bound
+            bool overflow = !session.closing && lineTooLong(input);
+            if (overflow) {
+                logMessage(LOG_WARN, "Line too long from %s, closing", peer);
+                out += "Line too long (at most ";
+                appendInt(out, MAX_LINE_LENGTH);
+                out += " bytes). Closing connection.\n";
+            }
+
+            // One send for every reply this read produced, followed by whatever
+            // background jobs pushed meanwhile. The handler may block on its own
+            // client, but without sendMutex: pushes keep queueing behind the replies
+            {
+                std::lock_guard<std::mutex> lock(sink.sendMutex);
+                out += sink.pushed;
+                sink.pushed.clear();
+            }
+            flushOutput(clientSocket, out);
+            std::lock_guard<std::mutex> lock(sink.sendMutex);
+            sink.busy = false;
+            sendPushed(sink); // The rest waits for waitForClient
+            if (overflow) break;
+            if (session.closing) {
+                logMessage(LOG_INFO, "Client %s said Bye", peer);
+                break;
+            }
+        } catch (const std::bad_alloc&) {
+            // One client's upload must not take the server (and everyone else) down with it
+            logMessage(LOG_ERROR, "Out of memory serving %s, closing", peer);
+            std::vector<Point>().swap(input.bulkPoints);
+            break;
         }
-        lastState = nowAtLeast100;
     }
+    setStatsActivity(STAT_BACKGROUND);
+    for (auto& registration : session.watches) {
+        removeWatch(registration.first->watches, registration.second);
+    }
+    for (auto& registration : session.subscriptions) {
+        unsubscribeHull(registration.first->feed, registration.second);
+    }
+    {
+        // Only this connection could fetch the results, so its running hulls stop
+        std::lock_guard<InstrumentedMutex> lock(ticketsMutex);
+        for (unsigned long ticket : session.hullTickets) {
+            auto it = hullTickets.find(ticket);
+            if (it != hullTickets.end() && !it->second.done) it->second.cancel->cancelled = true;
+        }
+    }
+    {
+        // Background jobs must not write to the closed (and maybe reused) descriptor
+        std::lock_guard<std::mutex> lock(sink.sendMutex);
+        sink.open = false;
+    }
+    close(sink.wakeFd);
+    close(clientSocket);
+    countConnection(false);
+    logMessage(LOG_INFO, "Client handler thread ending for %s", peer);
     return nullptr;
 }
 
 int main() {
     signal(SIGINT, signalHandler); // Handle Ctrl+C for graceful shutdown
+    signal(SIGUSR1, signalHandler); // Print the Stats counters
     
     int serverSocket;
     struct sockaddr_in serverAddr;
@@ -325,27 +1956,47 @@ int main() {
     }
 
     std::cout << "Convex Hull Server listening on port " << PORT << std::endl;
-    std::cout << "Available commands: Newgraph <n>, <x,y>, CH, Newpoint <x,y>, Removepoint <x,y>, Status" << std::endl;
+    std::cout << "Available commands: Use <name>, Newgraph [<name>] <n>, <x,y>, Loadpoints <n>, CH [timeout=<n>ms], CHAsync [timeout=<n>ms], CHResult <ticket>, CHCancel <ticket>, Watch <metric> <op> <value>, Unwatch <id>, Subscribe hull, Unsubscribe hull, Newpoint <x,y>, Removepoint <x,y>, Status, Stats, Bye" << std::endl;
     std::cout << "Server will create a new thread for each client connection (proactor)." << std::endl;
 
-    // Start watcher thread to monitor CH area
-    pthread_create(&watcherThread, nullptr, chAreaWatcherThread, nullptr);
+    startLogger();
+    startHullMonitor();
+
+    // The assignment's watcher: log when at least 100 units belong to the default graph's hull
+    std::shared_ptr<Watch> areaWatch = std::make_shared<Watch>();
+    areaWatch->threshold = 100.0;
+    addWatch(findGraph(DEFAULT_GRAPH, true)->watches, areaWatch);
+
+    // Workers for CHAsync
+    ComputePool pool;
+    hullPool = &pool;
 
     // PROACTOR: Start proactor instead of manual accept/thread loop
     pthread_t proactor_tid = startProactor(serverSocket, handleClient);
 
     while (serverRunning) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (statsRequested.exchange(false)) {
+            std::string stats;
+            appendStats(stats);
+            std::cout << stats << std::endl;
+        }
     }
 
-    // Cleanup: stop watcher thread
-    watcherRunning = false;
-    chAreaCond.notify_one();
-    pthread_join(watcherThread, nullptr);
-
     // Cleanup 
     close(serverSocket);
     stopProactor(proactor_tid);
+    {
+        // Nobody waits for the results any more, so queued and running hulls stop early
+        std::lock_guard<InstrumentedMutex> lock(ticketsMutex);
+        for (auto& entry : hullTickets) {
+            if (!entry.second.done) entry.second.cancel->cancelled = true;
+        }
+    }
+    // Jobs update graphs, tickets and client sinks, so the workers must be done
+    // before main returns and those are destroyed. Later CHAsync jobs never run
+    pool.shutdown();
+    stopHullMonitor();
 
     return 0;
 }
\ No newline at end of file
@@ -9,10 +9,33 @@
 #include "reactor_proactor.hpp"
 #include <condition_variable>
 #include <atomic>
+#include <memory>
+#include <map>
+#include <deque>
+#include <chrono>
+#include <cstdint>
+#include "compute_pool.hpp"
+#include "hull_monitor.hpp"
+#include "server_stats.hpp"
 
 #define PORT 9034
 #define MAXCLIENTS 10
-#define BUFSIZE 1024
+#define BUFSIZE 65536
+#define PEER_NAME_SIZE 32 // "255.255.255.255:65535"
+#define MAX_LOAD_POINTS (1 << 24)     // Most points one Loadpoints may announce
+#define LOAD_RESERVE_POINTS (1 << 20) // Reserved when a Loadpoints starts
+#define MAX_LINE_LENGTH 65536         // Longest command line or payload point; longer drops the client
+#define MAX_FINISHED_TICKETS 1024 // Finished CHAsync results kept for CHResult
+#define MAX_SESSION_HULLS 4       // CHAsync jobs one connection may have running
+#define MAX_RUNNING_HULLS 64      // CHAsync jobs running server-wide; each holds a graph copy
+#define HULL_CHECK_INTERVAL 65536 // Points between two cancellation checkpoints
+#define DEFAULT_GRAPH "default"   // Graph every connection starts on
+#define MAX_GRAPH_NAME 64
+#define MAX_GRAPHS 1024         // Named graphs the server holds; they are never reclaimed
+#define MAX_SESSION_WATCHES 256 // Watch registrations one connection may hold
+#define MAX_TRACKED_HULL 4096   // Larger hulls are recomputed rather than updated point by point
+#define MAX_PUSH_BACKLOG (1 << 20) // Pushed bytes a client may have waiting before hull deltas are skipped
+#define MAX_PUSH_BUFFER (16 << 20) // Pushed bytes a client may have waiting before it is dropped
 
 // Point structure
 struct Point {
@@ -25,6 +48,88 @@ struct Point {
     bool operator==(const Point& other) const;
 };
 
+// Watches and hull subscriptions, which need Point
+#include "watch.hpp"
+
+// Per-connection buffers: bytes received but not yet consumed, replies not
+// yet sent, plus any Loadpoints upload still in progress
+struct ClientInput {
+    std::string buffer;            // Received bytes
+    size_t pos = 0;                // Start of the unconsumed part of buffer
+    std::string output;            // Replies formatted but not yet sent
+    long pendingPoints = 0;        // Loadpoints payload points still expected
+    bool bulkInvalid = false;      // Some payload point failed to parse
+    std::vector<Point> bulkPoints; // Payload points parsed so far
+    uint64_t bulkStarted = 0;      // statsNow() at the Loadpoints line
+    bool negotiated = false;       // Protocol picked from the first bytes
+    bool binary = false;           // Connection speaks the binary protocol
+};
+
+// A connection's socket as seen by background jobs that push replies to it.
+// Pushes never block: what the socket does not take waits in pushed, and the
+// connection's handler sends it as the socket drains
+struct ClientSink {
+    int socket = -1;
+    int wakeFd = -1;      // eventfd telling the handler that pushed lines wait for the socket
+    std::mutex sendMutex; // Guards the fields below and every write to socket
+    bool open = true;     // Cleared before the handler closes the socket
+    bool busy = false;    // The handler is running a batch; pushes wait in pushed
+    std::string pushed;   // Lines not sent yet: pushed mid-batch, or more than the socket took
+};
+
+// A named graph. Clients on different graphs never share a lock
+struct Graph {
+    InstrumentedMutex mutex{LOCK_GRAPH}; // Guards every field below
+    std::vector<Point> points;
+    int counter = 0;              // Points still expected after Newgraph
+    unsigned long version = 0;    // Bumped by every change to points
+    unsigned long reshapedVersion = 0; // Last version that did more than append points
+    bool hullCached = false;      // hull and hullVertices describe the graph at hullVersion
+    unsigned long hullVersion = 0;
+    HullStats hull;
+    std::vector<Point> hullVertices; // Counter-clockwise
+    bool updateQueued = false;    // Waiting in the hull monitor
+    WatchSet watches;             // Has its own lock, so notifying never holds up the graph
+    HullFeed feed;                // Likewise for Subscribe hull
+};
+
+// Per-connection state the text command handlers can see
+struct ClientSession {
+    ClientInput input;            // Received bytes, replies and any Loadpoints upload
+    std::shared_ptr<ClientSink> sink;
+    std::shared_ptr<Graph> graph; // Graph picked with Use or Newgraph <name> <n>
+    std::string graphName;
+    bool closing = false;         // Said Bye: the connection closes after this batch's replies
+    std::vector<unsigned long> hullTickets; // CHAsync tickets that may still be running
+    // Watch registrations, with the graph each is on; dropped on disconnect
+    std::vector<std::pair<std::shared_ptr<Graph>, std::shared_ptr<Watch>>> watches;
+    // Hull subscriptions, at most one per graph; dropped on disconnect
+    std::vector<std::pair<std::shared_ptr<Graph>, std::shared_ptr<HullSubscription>>> subscriptions;
+};
+
+// Stop conditions and progress of one hull computation. The computing thread
+// polls it at checkpoints; only cancelled is touched by other threads
+struct HullCancel {
+    std::atomic<bool> cancelled{false}; // Set by CHCancel
+    bool hasDeadline = false;
+    std::chrono::steady_clock::time_point deadline;
+    int clientSocket = -1;              // Stop if this connection fails; -1 to ignore
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    const char* phase = "queued";       // What it was doing, for the report
+    size_t points = 0;                  // Graph size being hulled
+    size_t workDone = 0;                // Progress, in point steps out of workTotal
+    size_t workTotal = 0;
+    const char* stopReason = nullptr;   // Why it stopped early; nullptr while it may go on
+};
+
+// State of a CHAsync request
+struct HullTicket {
+    bool done = false;
+    std::string result;                 // Reply line once done, without the newline
+    std::shared_ptr<HullCancel> cancel;
+    std::weak_ptr<ClientSink> owner;    // Only this connection may read or cancel it
+};
+
 // Function declarations
 double crossProduct(const Point& O, const Point& A, const Point& B);
 
@@ -32,38 +137,167 @@ std::vector<Point> convexHull(std::vector<Point> points);
 
 double polygonArea(const std::vector<Point>& vertices);
 
-Point parsePoint(const std::string& pointStr);
+double polygonPerimeter(const std::vector<Point>& vertices);
+
+// Area, perimeter and vertex count of a hull
+HullStats measureHull(const std::vector<Point>& hull);
+
+// Whether p lies inside or on the counter-clockwise hull (3 or more vertices)
+bool insideHull(const std::vector<Point>& hull, const Point& p);
+
+// Grows the counter-clockwise hull to take in p; false if p was already inside
+bool extendHull(std::vector<Point>& hull, const Point& p);
+
+// Parses a number at p (after optional whitespace); returns the position after it or nullptr
+const char* parseDouble(const char* p, const char* end, double& value);
+
+// Parses "x,y" into point without allocating; false if malformed
+bool parsePoint(const char* begin, const char* end, Point& point);
+
+bool parsePoint(const std::string& pointStr, Point& point);
+
+// Parses up to pending whitespace-separated "x,y" tokens from [begin, end) into
+// points, decrementing pending per token and setting invalid on a bad one.
+// A token that runs into end is left for the next call. Returns bytes consumed.
+size_t scanPoints(const char* begin, const char* end, long& pending,
+                  std::vector<Point>& points, bool& invalid);
+
+// Appends received bytes to the connection's input
+void appendInput(ClientInput& input, const char* data, size_t len);
+
+// Takes the next complete line off the input; false if none is buffered yet
+bool nextLine(ClientInput& input, std::string& line);
+
+// Whether the unconsumed input is longer than a command line or payload point may be
+bool lineTooLong(const ClientInput& input);
+
+// Starts a Loadpoints upload from its arguments [args, end); appends an error
+// reply (without newline) to out if the count is invalid
+void startBulkLoad(ClientInput& input, const char* args, const char* end, std::string& out);
+
+// Parses buffered payload points; true once all expected points arrived
+bool consumeBulkPoints(ClientInput& input);
+
+// Replaces graph with the finished Loadpoints payload and appends the reply to out
+void finishBulkLoad(Graph& graph, ClientInput& input, std::string& out);
+
+// Formats "ip:port" of addr into text
+void formatPeer(const struct sockaddr_in& addr, char* text, size_t size);
 
 void sendToClient(int clientSocket, const std::string& message);
 
-std::string processCommand(const std::string& command);
+// Sends the buffered replies and empties output
+void flushOutput(int clientSocket, std::string& output);
 
-void* handleClient(int clientSocket);
+// Fast formatting into an output buffer; appendFixed matches printf("%.*f") and
+// appendPoint writes "(x,y)" like std::to_string
+void appendInt(std::string& out, long long value);
+void appendFixed(std::string& out, double value, int decimals);
+void appendPoint(std::string& out, const Point& point);
 
-// Global variables
-extern std::vector<Point> globalGraph;
+// Sends a binary frame as is, retrying partial sends
+void sendFrame(int clientSocket, const std::string& frame);
+
+// Hull of graph: the cached one if the graph has not changed since, else
+// computed on a snapshot (outside the lock), cached and published
+HullStats currentHull(Graph& graph);
+
+// Cached hull of graph if still valid; otherwise copies its points. Sets version either way
+bool cachedHull(Graph& graph, HullStats& stats, std::vector<Point>& snapshot, unsigned long& version);
+
+// Caches hull (taking its vertices) as the hull of the first pointCount points,
+// snapshotted at version. Points appended since are folded in; after any other
+// change the hull is dropped
+void cacheHull(Graph& graph, unsigned long version, size_t pointCount,
+               std::vector<Point>& hull, const HullStats& stats);
+
+// Keep graph's cached hull in step with a change to its points, and queue the
+// graph for its watches. Call with graph.mutex held, right after the version bump
+void trackAddedPoints(Graph& graph, const Point* points, size_t count);
+void trackRemovedPoint(Graph& graph, const Point& point);
+void trackReplacedPoints(Graph& graph);
+
+// Publishes graph's hull to its watches, recomputing it first if the cache is stale
+void publishCurrentHull(Graph& graph);
+
+// The graph called name; creates an empty one if there is none and create is
+// set, unless MAX_GRAPHS exist already. nullptr if there is none then
+std::shared_ptr<Graph> findGraph(const std::string& name, bool create);
+
+// Hands a freshly computed hull of the graph at version (vertices counter-clockwise)
+// to its watches and hull subscribers
+void publishHull(Graph& graph, unsigned long version, const HullStats& stats, const std::vector<Point>& hull);
+
+// Checkpoint of a cancellable hull; false (with cancel.stopReason set) once it should stop
+bool hullShouldContinue(HullCancel& cancel);
 
-extern int counter;
+// Cancellable convexHull: sorts points in place and fills hull, checking cancel
+// every HULL_CHECK_INTERVAL points. False if it stopped early
+bool convexHull(std::vector<Point>& points, std::vector<Point>& hull, HullCancel& cancel);
 
-extern std::mutex graphMutex;
+// Appends "timed out after 200 ms while sorting (37% done, 2000000 points)"
+void appendHullStopped(std::string& out, const HullCancel& cancel);
 
+// Parses CH/CHAsync options ("timeout=200ms", "timeout=2s") from [args, end) into
+// cancel; false if one is not understood
+bool parseHullOptions(const char* args, const char* end, HullCancel& cancel);
 
-// For the CH area watcher thread
-extern std::mutex chAreaMutex;
+// Writes a line to the client now, or after its current batch of replies;
+// never blocks. A client that leaves MAX_PUSH_BUFFER bytes unread is
+// disconnected rather than sent a stream with a line missing
+void pushToClient(ClientSink& sink, const std::string& line);
 
-extern std::condition_variable chAreaCond;
+// pushToClient, unless more than maxBacklog bytes already wait for the
+// client; then the line is dropped and false returned
+bool offerToClient(ClientSink& sink, const std::string& line, size_t maxBacklog);
 
-extern double lastCHArea;
+// Blocks until the client sent something (or hung up), sending the sink's
+// pushed lines meanwhile as the socket takes them; false if poll fails
+bool waitForClient(ClientSink& sink);
 
-extern std::atomic<bool> chAreaAtLeast100;
+// A whitespace-separated word of a command line, pointing into the line
+struct Token {
+    const char* begin;
+    const char* end;
+};
+
+// Takes the next token at or after p and advances p past it; empty at the end
+Token nextToken(const char*& p, const char* end);
+
+// Parses a whole token as an integer; false if it is not one
+bool parseInteger(const Token& token, long& value);
+
+// Whether name can name a graph: letters, digits, '_' and '-', starting with a letter
+bool validGraphName(const Token& name);
+
+// Runs one command and appends its reply to out; [args, end) is the rest of the line
+typedef void (*CommandHandler)(ClientSession& session, const char* args, const char* end, std::string& out);
+
+struct CommandEntry {
+    const char* name;
+    size_t length;
+    CommandHandler handler;
+};
+
+// Finds a command word in the dispatch table; nullptr if unknown
+const CommandEntry* findCommand(const char* word, size_t length);
+
+// Runs one command line and appends the reply line to out
+void processCommand(ClientSession& session, const std::string& command, std::string& out);
 
-extern std::atomic<bool> watcherRunning;
+void* handleClient(int clientSocket);
+
+// Global variables
+extern std::map<std::string, std::shared_ptr<Graph>> graphs;
 
+extern InstrumentedMutex graphsMutex;
 
-void* chAreaWatcherThread(void*);
+// CHAsync tickets, both running and finished, by number
+extern std::map<unsigned long, HullTicket> hullTickets;
 
-extern pthread_t watcherThread;
+extern InstrumentedMutex ticketsMutex;
 
-void notifyCHAreaChanged(double area);
+// Workers for CHAsync
+extern ComputePool* hullPool;
 
 #endif // CONVEX_HULL_HPP
\ No newline at end of file
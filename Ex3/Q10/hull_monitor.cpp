@@ -0,0 +1,69 @@
+#include "hull_monitor.hpp"
+#include "convex_hull.hpp"
+#include <thread>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+
+// Queued graphs with the time they are due; every entry gets the same window,
+// so the queue is in due order. Graphs are never removed from the graphs map
+// (MAX_GRAPHS bounds it instead), so plain pointers stay valid
+static std::deque<std::pair<std::chrono::steady_clock::time_point, Graph*>> monitorQueue;
+static std::mutex monitorMutex; // Guards the queue and monitorRunning
+static std::condition_variable monitorCond;
+static bool monitorRunning = false;
+static std::thread monitorThread;
+static std::chrono::milliseconds notifyDelay(10);
+
+static void monitorLoop() {
+    std::unique_lock<std::mutex> lock(monitorMutex);
+    while (true) {
+        monitorCond.wait(lock, [] { return !monitorRunning || !monitorQueue.empty(); });
+        if (!monitorRunning) break;
+
+        // Let the window fill up; mutations meanwhile find the graph queued already
+        if (monitorCond.wait_until(lock, monitorQueue.front().first, [] { return !monitorRunning; })) break;
+        Graph* graph = monitorQueue.front().second;
+        monitorQueue.pop_front();
+
+        lock.unlock();
+        {
+            // From here on a mutation queues the graph again
+            std::lock_guard<InstrumentedMutex> graphLock(graph->mutex);
+            graph->updateQueued = false;
+        }
+        publishCurrentHull(*graph);
+        lock.lock();
+    }
+}
+
+void startHullMonitor() {
+    const char* delay = getenv("CH_NOTIFY_MS");
+    if (delay) notifyDelay = std::chrono::milliseconds(atoi(delay));
+
+    std::lock_guard<std::mutex> lock(monitorMutex);
+    if (monitorRunning) return;
+    monitorRunning = true;
+    monitorThread = std::thread(monitorLoop);
+}
+
+void stopHullMonitor() {
+    {
+        std::lock_guard<std::mutex> lock(monitorMutex);
+        if (!monitorRunning) return;
+        monitorRunning = false;
+    }
+    monitorCond.notify_one();
+    monitorThread.join();
+}
+
+void scheduleHullUpdate(Graph& graph) {
+    if (graph.updateQueued) return;
+    graph.updateQueued = true;
+
+    std::lock_guard<std::mutex> lock(monitorMutex);
+    monitorQueue.emplace_back(std::chrono::steady_clock::now() + notifyDelay, &graph);
+    if (monitorQueue.size() == 1) monitorCond.notify_one();
+}
@@ -0,0 +1,28 @@
+#ifndef HULL_MONITOR_HPP
+#define HULL_MONITOR_HPP
+
+// Continuous hull monitoring for watched graphs.
+// Mutations keep a graph's cached hull current where they cheaply can (see
+// trackAddedPoints); a graph with watches is then queued here, and a
+// background thread publishes its hull to the watches once the debounce
+// window has passed. Every mutation inside one window is covered by a single
+// evaluation, so a burst of Newpoints gives each watch at most one
+// notification per window instead of one per point.
+//
+// The window comes from the CH_NOTIFY_MS environment variable (10 ms by
+// default). A change is published within the window plus, if the cached hull
+// had to be dropped, the time to recompute it.
+
+struct Graph;
+
+// Starts the monitor thread
+void startHullMonitor();
+
+// Stops it; queued graphs are not published
+void stopHullMonitor();
+
+// Queues graph for publishing unless it is queued already; call with graph.mutex held.
+// Graphs are never destroyed, so the queue keeps plain pointers
+void scheduleHullUpdate(Graph& graph);
+
+#endif // HULL_MONITOR_HPP
@@ -0,0 +1,352 @@
+#include "load_driver.hpp"
+#include <string>
+#include <deque>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/prctl.h>
+
+#define COORDINATE_RANGE 1000.0
+#define SETUP_TIMEOUT_MS 2000 // For the banner of a new connection
+
+typedef std::chrono::steady_clock Clock;
+
+const char* const operationNames[OP_COUNT] = {"newgraph", "newpoint", "removepoint", "ch", "status"};
+
+// A command written (or waiting to be written) whose reply is not complete yet
+struct Pending {
+    Operation op;
+    Clock::time_point due;      // When the schedule wanted it sent
+    Clock::time_point sent;     // When the write of its last byte began
+    size_t endOffset;           // Its end in the connection's byte stream
+    long replyLines;            // Reply lines still to come
+};
+
+// What one connection measured, in ms
+struct ConnectionResult {
+    std::vector<double> latency[OP_COUNT];   // From the due time
+    std::vector<double> serviceTime;         // From the send, all operations
+    long lost = 0;                           // Never answered
+};
+
+static int connectToServer(int port) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in serverAddr;
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &serverAddr.sin_addr);
+    if (sock < 0 || connect(sock, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
+        perror("Connection Failed");
+        if (sock >= 0) close(sock);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return sock;
+}
+
+// Reads up to count full lines, waiting at most timeoutMs; false on EOF or timeout
+static bool skipLines(int sock, std::string& buffer, int count, int timeoutMs) {
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (count > 0) {
+        size_t newline = buffer.find('\n');
+        if (newline != std::string::npos) {
+            buffer.erase(0, newline + 1);
+            count--;
+            continue;
+        }
+        int left = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - Clock::now()).count());
+        struct pollfd pfd = {sock, POLLIN, 0};
+        if (left <= 0 || poll(&pfd, 1, left) <= 0) return false;
+        char chunk[4096];
+        ssize_t n = read(sock, chunk, sizeof(chunk));
+        if (n <= 0) return false;
+        buffer.append(chunk, n);
+    }
+    return true;
+}
+
+class CommandStream {
+public:
+    CommandStream(const LoadOptions& options, unsigned long seed) : options(options), random(seed) {
+        double total = 0;
+        for (int op = 0; op < OP_COUNT; op++) total += options.weights[op];
+        double sum = 0;
+        for (int op = 0; op < OP_COUNT; op++) {
+            sum += options.weights[op];
+            cumulative[op] = sum / total;
+        }
+    }
+
+    // Appends the next command of the mix to out; returns its operation and reply line count
+    Operation next(std::string& out, long& replyLines) {
+        double pick = unit(random);
+        int op = 0;
+        while (op < OP_COUNT - 1 && pick >= cumulative[op]) op++;
+
+        switch (op) {
+        case OP_NEWGRAPH:
+            // "Ready for n points" and one "Point added" per point
+            out += "Newgraph " + std::to_string(options.bulk) + "\n";
+            for (long i = 0; i < options.bulk; i++) appendPoint(out, randomPoint());
+            added.clear();
+            replyLines = options.bulk + 1;
+            break;
+        case OP_NEWPOINT: {
+            Coordinates point = randomPoint();
+            out += "Newpoint ";
+            appendPoint(out, point);
+            added.push_back(point);
+            replyLines = 1;
+            break;
+        }
+        case OP_REMOVEPOINT: {
+            // One this connection added, if any; another connection's Newgraph may have taken it already
+            Coordinates point = randomPoint();
+            if (!added.empty()) {
+                size_t index = random() % added.size();
+                point = added[index];
+                added[index] = added.back();
+                added.pop_back();
+            }
+            out += "Removepoint ";
+            appendPoint(out, point);
+            replyLines = 1;
+            break;
+        }
+        case OP_CH:
+            out += "CH\n";
+            replyLines = 1;
+            break;
+        default:
+            out += "Status\n";
+            replyLines = 1;
+            break;
+        }
+        return static_cast<Operation>(op);
+    }
+
+private:
+    struct Coordinates {
+        double x, y;
+    };
+
+    Coordinates randomPoint() {
+        Coordinates point = {std::round(unit(random) * COORDINATE_RANGE * 100) / 100,
+                             std::round(unit(random) * COORDINATE_RANGE * 100) / 100};
+        return point;
+    }
+
+    static void appendPoint(std::string& out, const Coordinates& point) {
+        char text[64];
+        int n = snprintf(text, sizeof(text), "%.2f,%.2f\n", point.x, point.y);
+        out.append(text, n);
+    }
+
+    const LoadOptions& options;
+    std::mt19937_64 random;
+    std::uniform_real_distribution<double> unit{0.0, 1.0};
+    double cumulative[OP_COUNT];
+    std::vector<Coordinates> added;
+};
+
+static double milliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// A connection past the banner (and the Use), non-blocking; -1 if the server did not take it
+static int openConnection(const LoadOptions& options) {
+    int sock = connectToServer(options.port);
+    if (sock < 0) return -1;
+    std::string input;
+    bool ready = skipLines(sock, input, 1, SETUP_TIMEOUT_MS); // Banner
+    if (ready && !options.graph.empty()) {
+        std::string use = "Use " + options.graph + "\n";
+        ready = send(sock, use.data(), use.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(use.size()) &&
+                skipLines(sock, input, 1, SETUP_TIMEOUT_MS);
+    }
+    if (!ready) {
+        close(sock);
+        return -1;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    return sock;
+}
+
+// One connection's load: commands go out when due (or when the previous
+// reply is in, closed-loop), replies are matched to them in order by line count
+static void runConnection(const LoadOptions& options, int sock, int index, int count,
+                          Clock::time_point start, Clock::time_point stop, ConnectionResult& result) {
+    // Wake up on time for the schedule; the default 50us slack shows up as latency
+    prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+
+    CommandStream commands(options, options.seed * 1000003 + index);
+    bool openLoop = options.rate > 0;
+    // Connections share the rate and are staggered evenly within one interval
+    Clock::duration interval = openLoop ? std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(count / options.rate)) : Clock::duration::zero();
+    Clock::time_point due = start + interval * index / count;
+
+    std::deque<Pending> pending;
+    std::string output;        // Commands queued; output[written - outputOffset] is the next byte to write
+    size_t outputOffset = 0;   // Stream offset of output[0]
+    size_t written = 0;        // Bytes of the stream written so far
+    size_t unsent = 0;         // Index in pending of the first command not fully written
+    Clock::time_point drainDeadline = stop + std::chrono::milliseconds(DRAIN_TIMEOUT_MS);
+
+    while (true) {
+        Clock::time_point now = Clock::now();
+        bool loading = now < stop;
+        if (!loading && pending.empty()) break;
+        if (now >= drainDeadline) break;
+
+        // Queue what is due
+        if (loading) {
+            if (openLoop) {
+                while (due <= now && due < stop) {
+                    Pending command;
+                    command.op = commands.next(output, command.replyLines);
+                    command.due = due;
+                    command.endOffset = outputOffset + output.size();
+                    pending.push_back(command);
+                    due += interval;
+                }
+            } else if (pending.empty()) {
+                Pending command;
+                command.op = commands.next(output, command.replyLines);
+                command.due = now;
+                command.endOffset = outputOffset + output.size();
+                pending.push_back(command);
+            }
+        }
+
+        // Write as much as the socket takes
+        size_t unwritten = outputOffset + output.size() - written;
+        if (unwritten > 0) {
+            // Stamped before the call: on loopback the reply can be in before send returns
+            Clock::time_point sending = Clock::now();
+            ssize_t n = send(sock, output.data() + (written - outputOffset), unwritten, MSG_NOSIGNAL);
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) break;
+            if (n > 0) {
+                written += n;
+                unwritten -= n;
+                // Drop what is written once it is most of the buffer, not on every send
+                if (written - outputOffset > unwritten) {
+                    output.erase(0, written - outputOffset);
+                    outputOffset = written;
+                }
+                while (unsent < pending.size() && pending[unsent].endOffset <= written) {
+                    pending[unsent++].sent = sending;
+                }
+            }
+        }
+
+        // Wait for replies, room to write, or the next due command
+        // (ppoll, as a millisecond timeout would make the schedule late or spin)
+        long long waitNs = 100000000;
+        if (loading && openLoop) {
+            waitNs = std::max<long long>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::min(due, stop) - Clock::now()).count());
+        }
+        struct timespec timeout = {static_cast<time_t>(waitNs / 1000000000), static_cast<long>(waitNs % 1000000000)};
+        struct pollfd pfd = {sock, static_cast<short>(POLLIN | (unwritten > 0 ? POLLOUT : 0)), 0};
+        if (ppoll(&pfd, 1, &timeout, nullptr) <= 0 || !(pfd.revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+        char chunk[65536];
+        ssize_t n = read(sock, chunk, sizeof(chunk));
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) break;
+        if (n < 0) continue;
+        now = Clock::now();
+        for (ssize_t i = 0; i < n; i++) {
+            // A bulk Newgraph is answered point by point, before it is all written
+            if (chunk[i] != '\n' || pending.empty()) continue;
+            Pending& command = pending.front();
+            if (--command.replyLines > 0) continue;
+            result.latency[command.op].push_back(milliseconds(now - command.due));
+            result.serviceTime.push_back(milliseconds(now - command.sent));
+            pending.pop_front();
+            if (unsent > 0) unsent--;
+        }
+    }
+    result.lost = static_cast<long>(pending.size());
+    close(sock);
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+    return sorted[rank == 0 ? 0 : rank - 1];
+}
+
+bool parseMix(const char* mix, double weights[OP_COUNT]) {
+    for (int op = 0; op < OP_COUNT; op++) weights[op] = 0;
+    double total = 0;
+    const char* p = mix;
+    while (*p) {
+        const char* equals = strchr(p, '=');
+        if (!equals) return false;
+        int op = 0;
+        while (op < OP_COUNT && !(strlen(operationNames[op]) == static_cast<size_t>(equals - p) &&
+                                  strncmp(p, operationNames[op], equals - p) == 0)) op++;
+        if (op == OP_COUNT) return false;
+        char* next;
+        weights[op] = strtod(equals + 1, &next);
+        if (next == equals + 1 || weights[op] < 0) return false;
+        total += weights[op];
+        p = *next == ',' ? next + 1 : next;
+        if (*next != ',' && *next != '\0') return false;
+    }
+    return total > 0;
+}
+
+void runLoad(const LoadOptions& options, LoadResult& report) {
+    // Connected one after the other before the schedule starts: the servers
+    // listen with small backlogs, and a connection that only gets through on
+    // a SYN retry would start a second behind its schedule. Once the server
+    // stops taking connections (Q4 and Q6 serve ten clients), it gets no more
+    std::vector<int> sockets;
+    for (int i = 0; i < options.connections; i++) {
+        int sock = openConnection(options);
+        if (sock < 0) break;
+        sockets.push_back(sock);
+    }
+    int count = static_cast<int>(sockets.size());
+
+    std::vector<ConnectionResult> results(count);
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now() + std::chrono::milliseconds(50);
+    Clock::time_point stop = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.duration));
+    for (int i = 0; i < count; i++) {
+        threads.emplace_back(runConnection, std::cref(options), sockets[i], i, count, start, stop, std::ref(results[i]));
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    report = LoadResult();
+    report.failedConnections = options.connections - count;
+    for (ConnectionResult& result : results) {
+        for (int op = 0; op < OP_COUNT; op++) {
+            report.latency[op].insert(report.latency[op].end(), result.latency[op].begin(), result.latency[op].end());
+            report.all.insert(report.all.end(), result.latency[op].begin(), result.latency[op].end());
+        }
+        report.serviceTime.insert(report.serviceTime.end(), result.serviceTime.begin(), result.serviceTime.end());
+        report.lost += result.lost;
+    }
+    for (int op = 0; op < OP_COUNT; op++) std::sort(report.latency[op].begin(), report.latency[op].end());
+    std::sort(report.all.begin(), report.all.end());
+    std::sort(report.serviceTime.begin(), report.serviceTime.end());
+}
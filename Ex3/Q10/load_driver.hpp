@@ -0,0 +1,54 @@
+#ifndef LOAD_DRIVER_HPP
+#define LOAD_DRIVER_HPP
+
+#include <vector>
+#include <string>
+
+// The load behind load_generator and shootout: N connections to
+// 127.0.0.1, each replaying a weighted command mix, closed-loop or
+// open-loop at a fixed total rate (see load_generator.cpp for the details)
+
+#define DRAIN_TIMEOUT_MS 5000 // How long replies are waited for after the load stops
+
+enum Operation {
+    OP_NEWGRAPH,
+    OP_NEWPOINT,
+    OP_REMOVEPOINT,
+    OP_CH,
+    OP_STATUS,
+    OP_COUNT
+};
+
+// Names as used in mixes and reports, in Operation order
+extern const char* const operationNames[OP_COUNT];
+
+struct LoadOptions {
+    int connections = 4;
+    double duration = 10;          // Seconds
+    double rate = 0;               // Commands per second over all connections; 0 = closed loop
+    double weights[OP_COUNT] = {1, 40, 20, 30, 9};
+    long bulk = 1000;              // Points per Newgraph
+    std::string graph;             // "Use" on every connection first, if set (Q10 only)
+    int port = 9034;
+    unsigned long seed = 1;
+};
+
+// Latencies in ms, each list sorted
+struct LoadResult {
+    std::vector<double> latency[OP_COUNT];  // From the due time
+    std::vector<double> all;                // The same, all operations
+    std::vector<double> serviceTime;        // From the send, all operations
+    long lost = 0;                          // Never answered
+    int failedConnections = 0;              // Not taken by the server; the rest carry the load
+};
+
+// Parses "newpoint=40,ch=30" into weights; unnamed operations get weight 0
+bool parseMix(const char* mix, double weights[OP_COUNT]);
+
+// Runs the load for options.duration seconds, plus the drain of late replies
+void runLoad(const LoadOptions& options, LoadResult& result);
+
+// Nearest-rank percentile of sorted samples; 0 if there are none
+double percentile(const std::vector<double>& sorted, double p);
+
+#endif // LOAD_DRIVER_HPP
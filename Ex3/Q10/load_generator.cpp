@@ -0,0 +1,97 @@
+// Load generator for the convex hull servers (Q4, Q6, Q7, Q9 and Q10 all
+// speak the same text protocol on port 9034), always on 127.0.0.1.
+// Opens N connections, one thread each, and replays a weighted mix of
+// Newgraph (a bulk load of --bulk points), Newpoint, Removepoint, CH and
+// Status, either closed-loop (each connection sends its next command when
+// the previous reply is in) or open-loop at a fixed total rate.
+//
+// Open-loop latency is measured from when a command was due by the
+// schedule, not from when it was actually written: a stalled server delays
+// the sending too, and timing from the send would hide exactly that wait
+// (coordinated omission). The send-based figure is reported next to it.
+//
+// Usage: load_generator [options]
+//   --connections n   connections (default 4)
+//   --duration s      seconds of load (default 10)
+//   --rate n          commands per second over all connections; 0 = closed loop (default 0)
+//   --mix a=w,...     weights of newgraph, newpoint, removepoint, ch, status
+//                     (default newgraph=1,newpoint=40,removepoint=20,ch=30,status=9)
+//   --bulk n          points per Newgraph (default 1000)
+//   --use name        graph every connection works on (Q10 only; default: the shared one)
+//   --port n          server port (default 9034)
+//   --seed n          seed of the command and point stream (default 1)
+
+#include "load_driver.hpp"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void printRow(const char* name, const std::vector<double>& sorted, double seconds) {
+    printf("%-22s %10zu %10.0f %9.3f %9.3f %9.3f %9.3f\n", name, sorted.size(), sorted.size() / seconds,
+           percentile(sorted, 50), percentile(sorted, 99), percentile(sorted, 99.9),
+           sorted.empty() ? 0.0 : sorted.back());
+}
+
+int main(int argc, char* argv[]) {
+    LoadOptions options;
+    for (int i = 1; i < argc; i++) {
+        const char* option = argv[i];
+        const char* value = i + 1 < argc ? argv[++i] : nullptr;
+        if (!value) {
+            std::cerr << "Missing value for " << option << std::endl;
+            return 1;
+        }
+        if (strcmp(option, "--connections") == 0) {
+            options.connections = atoi(value);
+        } else if (strcmp(option, "--duration") == 0) {
+            options.duration = atof(value);
+        } else if (strcmp(option, "--rate") == 0) {
+            options.rate = atof(value);
+        } else if (strcmp(option, "--mix") == 0) {
+            if (!parseMix(value, options.weights)) {
+                std::cerr << "Invalid mix " << value << " (e.g. newpoint=40,ch=30)" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(option, "--bulk") == 0) {
+            options.bulk = atol(value);
+        } else if (strcmp(option, "--use") == 0) {
+            options.graph = value;
+        } else if (strcmp(option, "--port") == 0) {
+            options.port = atoi(value);
+        } else if (strcmp(option, "--seed") == 0) {
+            options.seed = strtoul(value, nullptr, 10);
+        } else {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+    if (options.connections <= 0 || options.duration <= 0 || options.rate < 0 || options.bulk <= 0) {
+        std::cerr << "Connections, duration and bulk must be positive, rate not negative" << std::endl;
+        return 1;
+    }
+
+    LoadResult result;
+    runLoad(options, result);
+
+    if (options.rate > 0) {
+        printf("%d connections, open loop at %.0f commands/s for %.1f s\n", options.connections, options.rate,
+               options.duration);
+    } else {
+        printf("%d connections, closed loop for %.1f s\n", options.connections, options.duration);
+    }
+    printf("%-22s %10s %10s %9s %9s %9s %9s\n", "latency (ms)", "count", "per s", "p50", "p99", "p99.9", "max");
+    for (int op = 0; op < OP_COUNT; op++) {
+        if (!result.latency[op].empty()) printRow(operationNames[op], result.latency[op], options.duration);
+    }
+    printRow("all", result.all, options.duration);
+    if (options.rate > 0) printRow("all, from send", result.serviceTime, options.duration);
+    if (result.lost > 0) {
+        printf("%ld commands unanswered %d s after the load stopped\n", result.lost, DRAIN_TIMEOUT_MS / 1000);
+    }
+    if (result.failedConnections > 0) {
+        printf("The server took only %d of %d connections\n", options.connections - result.failedConnections,
+               options.connections);
+    }
+    return result.failedConnections == options.connections ? 1 : 0;
+}
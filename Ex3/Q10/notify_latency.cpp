@@ -0,0 +1,192 @@
+// Watch notification latency against ingest rate.
+// For each rate, one connection streams random Newpoints inside a 10x10 square
+// into the graph "bench" while another watches "area >= 200". Now and then the
+// streaming connection sends a point far enough out to push the area over 200
+// (spliced into the hull) and later removes it again (a hull vertex, so the
+// hull is recomputed). The time from sending either command to the matching
+// notification is the end-to-end latency: queueing behind the stream, the
+// debounce window and the hull work together.
+//
+// Usage: notify_latency [rate ...]   (points per second; default 1000 10000 100000 1000000)
+// Run it against a server started with the desired CH_NOTIFY_MS.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <poll.h>
+
+#define PORT 9034
+#define TRIALS 20             // Crossings per rate, each one way and back
+#define TRIAL_GAP_MS 50       // Pause between two crossings
+#define NOTIFY_TIMEOUT_MS 5000
+
+typedef std::chrono::steady_clock Clock;
+
+// Buffered line reader over a socket
+struct LineReader {
+    int socket;
+    std::string buffer;
+
+    // Next line without the newline; false on EOF or after timeoutMs without one
+    bool next(std::string& line, int timeoutMs) {
+        Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (true) {
+            size_t newline = buffer.find('\n');
+            if (newline != std::string::npos) {
+                line.assign(buffer, 0, newline);
+                buffer.erase(0, newline + 1);
+                return true;
+            }
+            int left = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - Clock::now()).count());
+            struct pollfd pfd = {socket, POLLIN, 0};
+            if (left <= 0 || poll(&pfd, 1, left) <= 0) return false;
+            char chunk[65536];
+            ssize_t n = read(socket, chunk, sizeof(chunk));
+            if (n <= 0) return false;
+            buffer.append(chunk, n);
+        }
+    }
+};
+
+static int connectToServer() {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in serverAddr;
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(PORT);
+    inet_pton(AF_INET, "127.0.0.1", &serverAddr.sin_addr);
+    if (sock < 0 || connect(sock, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
+        perror("Connection Failed");
+        exit(EXIT_FAILURE);
+    }
+    return sock;
+}
+
+static void sendAll(int sock, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(sock, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        sent += n;
+    }
+}
+
+// Sends command and waits for the watcher to report "is now <state>"; latency in ms, or -1
+static double timeCrossing(int ingest, std::mutex& sendMutex, LineReader& watcher,
+                           const std::string& command, const char* state) {
+    Clock::time_point start = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        sendAll(ingest, command);
+    }
+    std::string line;
+    while (watcher.next(line, NOTIFY_TIMEOUT_MS)) {
+        if (line.find(state) != std::string::npos) {
+            return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+    }
+    return -1;
+}
+
+static double percentile(std::vector<double> samples, double p) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    size_t index = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+    return samples[index];
+}
+
+static void runRate(long rate) {
+    int ingest = connectToServer();
+    int watch = connectToServer();
+    LineReader ingestReader = {ingest, ""};
+    LineReader watcher = {watch, ""};
+    std::string line;
+    ingestReader.next(line, NOTIFY_TIMEOUT_MS); // Banners
+    watcher.next(line, NOTIFY_TIMEOUT_MS);
+
+    // A fresh 10x10 square (area 100), then the watch on it
+    sendAll(ingest, "Newgraph bench 4\n0,0\n10,0\n10,10\n0,10\n");
+    for (int i = 0; i < 5; i++) ingestReader.next(line, NOTIFY_TIMEOUT_MS);
+    sendAll(watch, "Use bench\nWatch area >= 200\n");
+    for (int i = 0; i < 2; i++) watcher.next(line, NOTIFY_TIMEOUT_MS);
+
+    // Replies to the stream are not needed, only drained
+    std::thread drainer([ingest]() {
+        char chunk[65536];
+        while (read(ingest, chunk, sizeof(chunk)) > 0) {}
+    });
+
+    std::mutex sendMutex;
+    std::atomic<bool> feeding{true};
+    std::atomic<long> fed{0};
+    Clock::time_point start = Clock::now();
+    std::thread feeder([&]() {
+        std::mt19937 random(42);
+        std::uniform_real_distribution<double> coordinate(1.0, 9.0);
+        std::string batch;
+        char text[64];
+        while (feeding) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            long due = static_cast<long>(elapsed * rate) - fed;
+            batch.clear();
+            for (long i = 0; i < due; i++) {
+                int n = snprintf(text, sizeof(text), "Newpoint %.3f,%.3f\n", coordinate(random), coordinate(random));
+                batch.append(text, n);
+            }
+            std::lock_guard<std::mutex> lock(sendMutex);
+            sendAll(ingest, batch);
+            fed += due;
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::vector<double> added, removed;
+    int lost = 0;
+    for (int trial = 0; trial < TRIALS; trial++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(TRIAL_GAP_MS));
+        double ms = timeCrossing(ingest, sendMutex, watcher, "Newpoint 50,5\n", "is now true");
+        if (ms < 0) lost++; else added.push_back(ms);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(TRIAL_GAP_MS));
+        ms = timeCrossing(ingest, sendMutex, watcher, "Removepoint 50,5\n", "is now false");
+        if (ms < 0) lost++; else removed.push_back(ms);
+    }
+    feeding = false;
+    feeder.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    shutdown(ingest, SHUT_WR);
+    drainer.join();
+    close(ingest);
+    close(watch);
+
+    printf("%10ld %10.0f %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f %5d\n", rate, fed / seconds,
+           percentile(added, 0.5), percentile(added, 0.99), percentile(added, 1.0),
+           percentile(removed, 0.5), percentile(removed, 0.99), percentile(removed, 1.0), lost);
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<long> rates;
+    for (int i = 1; i < argc; i++) rates.push_back(atol(argv[i]));
+    if (rates.empty()) rates = {1000, 10000, 100000, 1000000};
+
+    printf("Latency from command to notification, ms (add: hull extended, remove: hull recomputed)\n");
+    printf("%10s %10s %8s %8s %8s %8s %8s %8s %5s\n", "rate/s", "sent/s",
+           "add p50", "add p99", "add max", "rm p50", "rm p99", "rm max", "lost");
+    for (long rate : rates) runRate(rate);
+    return 0;
+}
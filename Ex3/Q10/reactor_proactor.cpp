@@ -4,6 +4,9 @@
 #include <unistd.h>
 #include <cstring>
 #include <iostream>
+#include <atomic>
+#include <cerrno>
+#include <sys/eventfd.h>
 #include <pthread.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -12,16 +15,31 @@
 
 #define MAX_FD 1024
 
-proactorFunc globalProactorFunc = nullptr;
+// Posted task, linked into the reactor's multi-producer queue
+struct reactorTaskNode {
+    reactorTask task;
+    void* arg;
+    reactorTaskNode* next;
+};
 
 struct reactorStruct {
     std::unordered_set<int> fds; // Set of active file descriptors
     reactorFunc funcs[MAX_FD] = {nullptr}; // Callback functions per fd
-    bool running = false; // Whether the loop is running
+    reactorCtxFunc ctxFuncs[MAX_FD] = {nullptr}; // Context-carrying callbacks per fd
+    void* ctxs[MAX_FD] = {nullptr}; // Context handed to ctxFuncs
+    std::atomic<bool> running{false}; // Whether the loop is running
+    std::atomic<reactorTaskNode*> tasks{nullptr}; // Tasks posted from other threads (newest first)
+    int wakeFd = -1; // eventfd signalled by postToReactor
 };
 
 void* startReactor() {
     reactorStruct* r = new reactorStruct;
+    r->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (r->wakeFd < 0) {
+        perror("eventfd");
+        delete r;
+        return nullptr;
+    }
     r->running = true;  // Start running immediately
     return static_cast<void*>(r);
 }
@@ -31,6 +49,18 @@ int addFdToReactor(void* reactor, int fd, reactorFunc func) {
     auto r = static_cast<reactorStruct*>(reactor);
     r->fds.insert(fd);
     r->funcs[fd] = func;
+    r->ctxFuncs[fd] = nullptr;
+    r->ctxs[fd] = nullptr;
+    return 0;
+}
+
+int addFdToReactorCtx(void* reactor, int fd, reactorCtxFunc func, void* ctx) {
+    if (!reactor || fd < 0 || fd >= MAX_FD) return -1;
+    auto r = static_cast<reactorStruct*>(reactor);
+    r->fds.insert(fd);
+    r->funcs[fd] = nullptr;
+    r->ctxFuncs[fd] = func;
+    r->ctxs[fd] = ctx;
     return 0;
 }
 
@@ -39,6 +69,8 @@ int removeFdFromReactor(void* reactor, int fd) {
     auto r = static_cast<reactorStruct*>(reactor);
     r->fds.erase(fd);
     r->funcs[fd] = nullptr;
+    r->ctxFuncs[fd] = nullptr;
+    r->ctxs[fd] = nullptr;
     return 0;
 }
 
@@ -46,10 +78,59 @@ int stopReactor(void* reactor) {
     if (!reactor) return -1;
     auto r = static_cast<reactorStruct*>(reactor);
     r->running = false;
+
+    // Drop tasks that never got to run
+    reactorTaskNode* node = r->tasks.exchange(nullptr);
+    while (node) {
+        reactorTaskNode* next = node->next;
+        delete node;
+        node = next;
+    }
+    close(r->wakeFd);
     delete r;
     return 0;
 }
 
+int postToReactor(void* reactor, reactorTask task, void* arg) {
+    if (!reactor || !task) return -1;
+    auto r = static_cast<reactorStruct*>(reactor);
+    if (!r->running) return -1;
+
+    // Lock-free push; the reactor thread takes the whole list at once
+    reactorTaskNode* node = new reactorTaskNode{task, arg, r->tasks.load(std::memory_order_relaxed)};
+    while (!r->tasks.compare_exchange_weak(node->next, node,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+    }
+
+    uint64_t one = 1;
+    if (write(r->wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("write (eventfd)");
+    }
+    return 0;
+}
+
+// Run all tasks posted so far, oldest first
+static void runPostedTasks(reactorStruct* r) {
+    reactorTaskNode* node = r->tasks.exchange(nullptr, std::memory_order_acquire);
+
+    // The queue is a stack, reverse it to keep posting order
+    reactorTaskNode* ordered = nullptr;
+    while (node) {
+        reactorTaskNode* next = node->next;
+        node->next = ordered;
+        ordered = node;
+        node = next;
+    }
+
+    while (ordered) {
+        reactorTaskNode* next = ordered->next;
+        ordered->task(ordered->arg);
+        delete ordered;
+        ordered = next;
+    }
+}
+
 // Run one iteration of the reactor event loop
 int runReactorOnce(void* reactor) {
     if (!reactor) return -1;
@@ -60,7 +141,8 @@ int runReactorOnce(void* reactor) {
     fd_set readfds;
     struct timeval tv;
     FD_ZERO(&readfds);
-    int maxfd = 0;
+    FD_SET(r->wakeFd, &readfds);
+    int maxfd = r->wakeFd;
 
     for (int fd : r->fds) {
         FD_SET(fd, &readfds);
@@ -77,11 +159,21 @@ int runReactorOnce(void* reactor) {
         return -1;
     }
 
+    if (FD_ISSET(r->wakeFd, &readfds)) {
+        uint64_t pending;
+        if (read(r->wakeFd, &pending, sizeof(pending)) < 0 && errno != EAGAIN) {
+            perror("read (eventfd)");
+        }
+    }
+    runPostedTasks(r);
+
     auto fds = r->fds;  // Copy to avoid iterator invalidation
     for (int fd : fds) {
         if (FD_ISSET(fd, &readfds)) {
             if (r->funcs[fd]) {
                 r->funcs[fd](fd);
+            } else if (r->ctxFuncs[fd]) {
+                r->ctxFuncs[fd](fd, r->ctxs[fd]);
             }
         }
     }
@@ -97,23 +189,31 @@ int runReactorOnce(void* reactor) {
 struct proactorArgs {
     int sockfd;
     proactorFunc threadFunc;
+    proactorCtxFunc ctxFunc;
+    void* ctx;
     bool running;
 };
 
-// Helper to call proactorFunc with int argument
+// Per-client arguments owned by the handler thread
+struct proactorClientArgs {
+    int clientfd;
+    proactorFunc threadFunc;
+    proactorCtxFunc ctxFunc;
+    void* ctx;
+};
+
+// Helper to call the registered handler with the client fd (and context)
 static void* proactorThreadWrapper(void* arg) {
-    // arg is actually the clientfd cast to void*
-    int clientfd = (int)(intptr_t)arg;
-    extern proactorFunc globalProactorFunc; // Forward declaration
-    return globalProactorFunc(clientfd);
+    proactorClientArgs args = *static_cast<proactorClientArgs*>(arg);
+    delete static_cast<proactorClientArgs*>(arg);
+    if (args.ctxFunc) return args.ctxFunc(args.clientfd, args.ctx);
+    return args.threadFunc(args.clientfd);
 }
 
 // Start the proactor main loop in a separate thread
 static void* proactorMain(void* arg) {
     proactorArgs* args = static_cast<proactorArgs*>(arg);
     int listenfd = args->sockfd;
-    proactorFunc func = args->threadFunc;
-    globalProactorFunc = func; 
 
     while (args->running) {
         struct sockaddr_in clientAddr;
@@ -125,9 +225,11 @@ static void* proactorMain(void* arg) {
         }
         // Create a new thread to handle the client
         pthread_t tid;
-        int ret = pthread_create(&tid, nullptr, proactorThreadWrapper, (void*)(intptr_t)clientfd);
+        proactorClientArgs* clientArgs = new proactorClientArgs{clientfd, args->threadFunc, args->ctxFunc, args->ctx};
+        int ret = pthread_create(&tid, nullptr, proactorThreadWrapper, clientArgs);
         if (ret != 0) {
             perror("pthread_create");
+            delete clientArgs;
             close(clientfd);
         } else {
             pthread_detach(tid); // Detach so resources are freed when thread exits
@@ -140,7 +242,19 @@ static void* proactorMain(void* arg) {
 // Start the proactor thread
 pthread_t startProactor(int sockfd, proactorFunc threadFunc) {
     pthread_t tid;
-    proactorArgs* args = new proactorArgs{sockfd, threadFunc, true};
+    proactorArgs* args = new proactorArgs{sockfd, threadFunc, nullptr, nullptr, true};
+    if (pthread_create(&tid, nullptr, proactorMain, args) != 0) {
+        perror("pthread_create (proactor)");
+        delete args;
+        return 0;
+    }
+    return tid;
+}
+
+// Start the proactor thread with a per-proactor context
+pthread_t startProactorCtx(int sockfd, proactorCtxFunc threadFunc, void* ctx) {
+    pthread_t tid;
+    proactorArgs* args = new proactorArgs{sockfd, nullptr, threadFunc, ctx, true};
     if (pthread_create(&tid, nullptr, proactorMain, args) != 0) {
         perror("pthread_create (proactor)");
         delete args;
@@ -0,0 +1,217 @@
+#include "server_stats.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+const char* const hullPhaseNames[HULL_PHASE_COUNT] = {"copy", "sort", "scan", "area"};
+const char* const lockClassNames[LOCK_CLASS_COUNT] = {"graph", "watches", "graphs", "tickets"};
+
+#define HISTOGRAM_SUB (1u << HISTOGRAM_SUB_BITS)
+
+// One thread's histogram
+struct LatencyHistogram {
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> max;
+    std::atomic<uint64_t> buckets[HISTOGRAM_BUCKETS];
+};
+
+// One thread's acquisitions of one lock class
+struct LockCounters {
+    LatencyHistogram wait, hold;
+    std::atomic<uint64_t> contended;
+    std::atomic<uint64_t> heldBy[STAT_SLOTS + 1];
+    std::atomic<uint64_t> waitedBy[STAT_SLOTS + 1];
+};
+
+// Everything one thread counts; only that thread writes it
+struct ThreadStats {
+    LatencyHistogram commands[STAT_SLOTS];
+    LatencyHistogram hullPhases[HULL_PHASE_COUNT];
+    std::atomic<uint64_t> cacheHits, cacheMisses;
+    std::atomic<uint64_t> bytesIn, bytesOut;
+    std::atomic<uint64_t> connectionsOpened, connectionsClosed;
+    LockCounters locks[LOCK_CLASS_COUNT];
+};
+
+// Blocks of the running threads, and the sums of those that exited
+struct StatsRegistry {
+    std::mutex mutex;
+    std::vector<ThreadStats*> live;
+    ServerStats retired;
+};
+
+static StatsRegistry& registry() {
+    // Never destroyed: detached threads may still exit while the process does
+    static StatsRegistry* instance = new StatsRegistry();
+    return *instance;
+}
+
+// The single writer may add without a read-modify-write
+static inline void add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+static inline uint64_t load(const std::atomic<uint64_t>& counter) {
+    return counter.load(std::memory_order_relaxed);
+}
+
+static size_t bucketOf(uint64_t nanoseconds) {
+    if (nanoseconds < HISTOGRAM_SUB) return nanoseconds;
+    int exponent = 63 - __builtin_clzll(nanoseconds);
+    // The top HISTOGRAM_SUB_BITS + 1 bits: HISTOGRAM_SUB .. 2 * HISTOGRAM_SUB - 1
+    uint64_t mantissa = nanoseconds >> (exponent - HISTOGRAM_SUB_BITS);
+    size_t index = (exponent - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB + (mantissa - HISTOGRAM_SUB);
+    return std::min<size_t>(index, HISTOGRAM_BUCKETS - 1);
+}
+
+// Largest value that falls into bucket
+static uint64_t bucketTop(size_t bucket) {
+    if (bucket < HISTOGRAM_SUB) return bucket;
+    int exponent = bucket / HISTOGRAM_SUB + HISTOGRAM_SUB_BITS - 1;
+    uint64_t mantissa = bucket % HISTOGRAM_SUB + HISTOGRAM_SUB;
+    return ((mantissa + 1) << (exponent - HISTOGRAM_SUB_BITS)) - 1;
+}
+
+uint64_t LatencySummary::percentile(double p) const {
+    if (count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * count));
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank) return std::min(bucketTop(b), max);
+    }
+    return max;
+}
+
+static void record(LatencyHistogram& histogram, uint64_t nanoseconds) {
+    add(histogram.buckets[bucketOf(nanoseconds)], 1);
+    add(histogram.count, 1);
+    if (nanoseconds > load(histogram.max)) histogram.max.store(nanoseconds, std::memory_order_relaxed);
+}
+
+static void addHistogram(LatencySummary& sum, const LatencyHistogram& histogram) {
+    sum.count += load(histogram.count);
+    sum.max = std::max(sum.max, load(histogram.max));
+    for (size_t b = 0; b < HISTOGRAM_BUCKETS; b++) sum.buckets[b] += load(histogram.buckets[b]);
+}
+
+static void addLock(LockSummary& sum, const LockCounters& lock) {
+    addHistogram(sum.wait, lock.wait);
+    addHistogram(sum.hold, lock.hold);
+    sum.contended += load(lock.contended);
+    for (int s = 0; s <= STAT_SLOTS; s++) {
+        sum.heldBy[s] += load(lock.heldBy[s]);
+        sum.waitedBy[s] += load(lock.waitedBy[s]);
+    }
+}
+
+static void addThread(ServerStats& sum, const ThreadStats& block) {
+    for (int s = 0; s < STAT_SLOTS; s++) addHistogram(sum.commands[s], block.commands[s]);
+    for (int p = 0; p < HULL_PHASE_COUNT; p++) addHistogram(sum.hullPhases[p], block.hullPhases[p]);
+    sum.cacheHits += load(block.cacheHits);
+    sum.cacheMisses += load(block.cacheMisses);
+    sum.bytesIn += load(block.bytesIn);
+    sum.bytesOut += load(block.bytesOut);
+    sum.connectionsOpened += load(block.connectionsOpened);
+    sum.connectionsClosed += load(block.connectionsClosed);
+    for (int c = 0; c < LOCK_CLASS_COUNT; c++) addLock(sum.locks[c], block.locks[c]);
+}
+
+// Registers the thread's block on first use; folds it into the retired sums when the thread exits
+struct ThreadStatsOwner {
+    ThreadStats* block = nullptr;
+
+    ~ThreadStatsOwner() {
+        if (!block) return;
+        StatsRegistry& stats = registry();
+        std::lock_guard<std::mutex> lock(stats.mutex);
+        addThread(stats.retired, *block);
+        stats.live.erase(std::find(stats.live.begin(), stats.live.end(), block));
+        delete block;
+    }
+};
+
+static thread_local ThreadStatsOwner owner;
+static thread_local int activity = STAT_BACKGROUND;
+
+static ThreadStats& threadStats() {
+    if (!owner.block) {
+        ThreadStats* block = new ThreadStats(); // Zeroed
+        StatsRegistry& stats = registry();
+        std::lock_guard<std::mutex> lock(stats.mutex);
+        stats.live.push_back(block);
+        owner.block = block;
+    }
+    return *owner.block;
+}
+
+uint64_t statsNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void setStatsActivity(int slot) {
+    activity = slot >= 0 && slot < STAT_SLOTS ? slot : STAT_BACKGROUND;
+}
+
+void InstrumentedMutex::lock() {
+    // A thread's first acquisition allocates its block, which must not count as holding
+    LockCounters& counters = threadStats().locks[lockClass];
+    if (mutex.try_lock()) {
+        acquired = statsNow();
+        record(counters.wait, 0);
+        return;
+    }
+    uint64_t started = statsNow();
+    mutex.lock();
+    acquired = statsNow();
+    uint64_t waited = acquired - started;
+    record(counters.wait, waited);
+    add(counters.contended, 1);
+    add(counters.waitedBy[activity], waited);
+}
+
+void InstrumentedMutex::unlock() {
+    uint64_t held = statsNow() - acquired;
+    mutex.unlock();
+    LockCounters& counters = threadStats().locks[lockClass];
+    record(counters.hold, held);
+    add(counters.heldBy[activity], held);
+}
+
+void recordCommand(int slot, uint64_t nanoseconds) {
+    if (slot >= 0 && slot < STAT_SLOTS) record(threadStats().commands[slot], nanoseconds);
+}
+
+void recordHullPhase(HullPhase phase, uint64_t nanoseconds) {
+    record(threadStats().hullPhases[phase], nanoseconds);
+}
+
+void countHullCache(bool hit) {
+    ThreadStats& block = threadStats();
+    add(hit ? block.cacheHits : block.cacheMisses, 1);
+}
+
+void countBytesIn(size_t bytes) {
+    add(threadStats().bytesIn, bytes);
+}
+
+void countBytesOut(size_t bytes) {
+    add(threadStats().bytesOut, bytes);
+}
+
+void countConnection(bool opened) {
+    ThreadStats& block = threadStats();
+    add(opened ? block.connectionsOpened : block.connectionsClosed, 1);
+}
+
+void collectStats(ServerStats& stats) {
+    StatsRegistry& all = registry();
+    std::lock_guard<std::mutex> lock(all.mutex);
+    stats = all.retired;
+    for (const ThreadStats* block : all.live) addThread(stats, *block);
+}
@@ -0,0 +1,114 @@
+#ifndef SERVER_STATS_HPP
+#define SERVER_STATS_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+
+// Server counters behind the Stats command and the SIGUSR1 dump.
+// Every thread that records gets a block of its own, written with relaxed
+// loads and stores only: one writer per block, so no locked instruction and
+// no cache line shared with other threads. Collecting sums the live blocks
+// plus whatever exited threads left behind; a block read mid-update is off
+// by at most the command in flight.
+//
+// Lock waits and holds are charged to the command the thread is running
+// (setStatsActivity), so a slow command can be split into the time it spent
+// queueing for a lock and the time it spent on its own work.
+//
+// Latencies go into HDR-style histograms: exact below 8 ns, then 8 buckets
+// per power of two, so a percentile is within 12.5% up to 2^38 ns (275 s).
+
+#define STAT_SLOTS 24          // Commands a server may time, numbered by the caller
+#define STAT_BACKGROUND STAT_SLOTS // Activity of threads outside any command
+#define HISTOGRAM_SUB_BITS 3   // log2 of the buckets per power of two
+#define HISTOGRAM_BUCKETS 288  // 8 exact ones and 35 powers of two; longer times share the last
+
+// Phases of a full hull computation
+enum HullPhase {
+    HULL_COPY,  // Snapshot of the points, taken under the graph lock
+    HULL_SORT,
+    HULL_SCAN,  // Lower and upper chain
+    HULL_AREA,  // Area and perimeter
+    HULL_PHASE_COUNT
+};
+
+// Names, in HullPhase order
+extern const char* const hullPhaseNames[HULL_PHASE_COUNT];
+
+// Locks instrumented with InstrumentedMutex, by what they guard
+enum LockClass {
+    LOCK_GRAPH,   // Every Graph::mutex
+    LOCK_WATCHES, // Every WatchSet::mutex (the area watches)
+    LOCK_GRAPHS,  // The graph map
+    LOCK_TICKETS, // The CHAsync tickets
+    LOCK_CLASS_COUNT
+};
+
+// Names, in LockClass order
+extern const char* const lockClassNames[LOCK_CLASS_COUNT];
+
+// A histogram summed over threads
+struct LatencySummary {
+    uint64_t count;
+    uint64_t max; // ns
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+
+    // Upper end of the bucket holding percentile p (0-100), in ns; 0 if empty
+    uint64_t percentile(double p) const;
+};
+
+// One lock class summed over threads. Time by activity is indexed by
+// command slot, with STAT_BACKGROUND last
+struct LockSummary {
+    LatencySummary wait; // Every acquisition, 0 if the lock was free
+    LatencySummary hold;
+    uint64_t contended;  // Acquisitions that found the lock taken
+    uint64_t heldBy[STAT_SLOTS + 1];   // ns
+    uint64_t waitedBy[STAT_SLOTS + 1]; // ns
+};
+
+struct ServerStats {
+    LatencySummary commands[STAT_SLOTS];
+    LatencySummary hullPhases[HULL_PHASE_COUNT];
+    uint64_t cacheHits, cacheMisses; // Hull requests answered from the cached hull or not
+    uint64_t bytesIn, bytesOut;
+    uint64_t connectionsOpened, connectionsClosed;
+    LockSummary locks[LOCK_CLASS_COUNT];
+};
+
+// A std::mutex that records how long each acquisition waited, how long the
+// lock was then held, and for which activity. Works with std::lock_guard
+class InstrumentedMutex {
+public:
+    explicit InstrumentedMutex(LockClass lockClass) : lockClass(lockClass), acquired(0) {}
+    InstrumentedMutex(const InstrumentedMutex&) = delete;
+    InstrumentedMutex& operator=(const InstrumentedMutex&) = delete;
+
+    void lock();
+    void unlock();
+
+private:
+    std::mutex mutex;
+    LockClass lockClass;
+    uint64_t acquired; // statsNow() when the holder got the lock; only the holder touches it
+};
+
+// Nanoseconds on the steady clock
+uint64_t statsNow();
+
+// The command slot this thread's lock waits and holds are charged to from
+// now on; STAT_BACKGROUND (the default) once it is outside any command
+void setStatsActivity(int slot);
+
+void recordCommand(int slot, uint64_t nanoseconds);
+void recordHullPhase(HullPhase phase, uint64_t nanoseconds);
+void countHullCache(bool hit);
+void countBytesIn(size_t bytes);
+void countBytesOut(size_t bytes);
+void countConnection(bool opened);
+
+// Sums every thread's counters into stats
+void collectStats(ServerStats& stats);
+
+#endif // SERVER_STATS_HPP
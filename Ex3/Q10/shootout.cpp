@@ -0,0 +1,296 @@
+// Server architecture shootout. Runs each server (Q4 select loop, Q6
+// reactor, Q7 thread per client, Q9 proactor, Q10 proactor + watches)
+// under the same scripted workloads, one fresh server process per run,
+// and prints one comparison report: throughput and latency percentiles
+// from the load driver, and the server's CPU time, context switches and
+// peak RSS from its rusage (wait4, so threads that already exited count).
+//
+// Usage: shootout [options]   (run from Q10; "make shootout" in Ex3 builds all and runs it)
+//   --root dir         the Ex3 directory (default ..)
+//   --duration s       seconds of load per run (default 5)
+//   --servers a,b,...  servers to run (default Q4,Q6,Q7,Q9,Q10)
+//   --workloads a,...  workloads to run (default all, see workloads below)
+//   --csv file         also write every measurement to file as CSV
+//
+// Everything runs on 127.0.0.1:9034, which must be free.
+
+#include "load_driver.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define PORT 9034
+#define START_TIMEOUT_MS 5000
+#define STOP_TIMEOUT_MS 3000
+
+struct Server {
+    const char* name;
+    const char* binary;        // In the directory of the same name
+    const char* architecture;
+};
+
+static const Server servers[] = {
+    {"Q4", "convex_hull", "select loop"},
+    {"Q6", "convex_hull_server", "reactor"},
+    {"Q7", "convex_hull", "thread per client"},
+    {"Q9", "convex_hull_server", "proactor"},
+    {"Q10", "convex_hull_server", "proactor + watches"},
+};
+
+#define DEFAULT_MIX "newgraph=1,newpoint=40,removepoint=20,ch=30,status=9"
+
+struct Workload {
+    const char* name;
+    const char* description;
+    int connections;
+    double rate;               // 0 = closed loop
+    const char* mix;
+    long bulk;
+};
+
+static const Workload workloads[] = {
+    {"mixed-8", "default mix, 8 connections, closed loop", 8, 0, DEFAULT_MIX, 1000},
+    {"mixed-64", "default mix, 64 connections, closed loop", 64, 0, DEFAULT_MIX, 1000},
+    {"paced-20k", "default mix at 20000/s over 16 connections", 16, 20000, DEFAULT_MIX, 1000},
+    {"ingest", "Newpoint only, 8 connections, closed loop", 8, 0, "newpoint=1", 1000},
+    {"hull-heavy", "Newgraph of 20000 points and CH 1:10, 8 connections, closed loop", 8, 0, "newgraph=1,ch=10", 20000},
+};
+
+// One server under one workload
+struct Measurement {
+    const Server* server;
+    const Workload* workload;
+    bool ran;
+    double throughput;          // Answered commands per second
+    double p50, p99, p999, max; // ms, from the due time
+    long lost;
+    int failedConnections;
+    double cpuSeconds;          // User + system
+    long voluntarySwitches, involuntarySwitches;
+    double maxRssMb;
+};
+
+// Starts the server in its directory, stdout and stderr to /dev/null and
+// stdin on a pipe (the console loops of Q4 and Q6 would see EOF otherwise)
+static pid_t startServer(const std::string& root, const Server& server, int& console) {
+    std::string directory = root + "/" + server.name;
+    std::string path = "./" + std::string(server.binary);
+    int fds[2];
+    if (pipe(fds) < 0) return -1;
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(fds[0], STDIN_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        if (chdir(directory.c_str()) == 0) execl(path.c_str(), server.binary, static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    close(fds[0]);
+    console = fds[1];
+    return pid;
+}
+
+// Waits until the port accepts connections; false if the server exited or took too long
+static bool waitForServer(pid_t pid) {
+    for (int waited = 0; waited < START_TIMEOUT_MS; waited += 20) {
+        int status;
+        if (waitpid(pid, &status, WNOHANG) == pid) return false;
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in serverAddr;
+        memset(&serverAddr, 0, sizeof(serverAddr));
+        serverAddr.sin_family = AF_INET;
+        serverAddr.sin_port = htons(PORT);
+        inet_pton(AF_INET, "127.0.0.1", &serverAddr.sin_addr);
+        bool up = connect(sock, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) == 0;
+        close(sock);
+        if (up) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return false;
+}
+
+// Ctrl+C as an operator would, then SIGKILL if that is ignored; the rusage covers the whole run
+static void stopServer(pid_t pid, int console, struct rusage& usage) {
+    kill(pid, SIGINT);
+    int status;
+    pid_t done = 0;
+    for (int waited = 0; waited < STOP_TIMEOUT_MS && done == 0; waited += 20) {
+        done = wait4(pid, &status, WNOHANG, &usage);
+        if (done == 0) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    if (done == 0) {
+        kill(pid, SIGKILL);
+        wait4(pid, &status, 0, &usage);
+    }
+    close(console);
+}
+
+static bool runMeasurement(const std::string& root, double duration, Measurement& m) {
+    LoadOptions options;
+    options.connections = m.workload->connections;
+    options.duration = duration;
+    options.rate = m.workload->rate;
+    options.bulk = m.workload->bulk;
+    parseMix(m.workload->mix, options.weights);
+
+    int console;
+    pid_t pid = startServer(root, *m.server, console);
+    if (pid < 0) return false;
+    if (!waitForServer(pid)) {
+        std::cerr << m.server->name << " did not start listening on port " << PORT << std::endl;
+        struct rusage ignored;
+        stopServer(pid, console, ignored);
+        return false;
+    }
+
+    LoadResult result;
+    runLoad(options, result);
+    struct rusage usage;
+    stopServer(pid, console, usage);
+
+    m.ran = true;
+    m.throughput = result.all.size() / duration;
+    m.p50 = percentile(result.all, 50);
+    m.p99 = percentile(result.all, 99);
+    m.p999 = percentile(result.all, 99.9);
+    m.max = result.all.empty() ? 0 : result.all.back();
+    m.lost = result.lost;
+    m.failedConnections = result.failedConnections;
+    m.cpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+                   usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    m.voluntarySwitches = usage.ru_nvcsw;
+    m.involuntarySwitches = usage.ru_nivcsw;
+    m.maxRssMb = usage.ru_maxrss / 1024.0;
+    return true;
+}
+
+static void printWorkload(const Workload& workload, const std::vector<Measurement>& measurements, double duration) {
+    printf("\n== %s: %s, %.0f s\n", workload.name, workload.description, duration);
+    printf("%-5s %-19s %10s %9s %9s %9s %9s %8s %9s %10s %10s %8s %6s\n", "", "architecture", "cmds/s",
+           "p50 ms", "p99 ms", "p99.9 ms", "max ms", "cpu s", "cpu us/op", "vol cs", "invol cs", "rss MB", "lost");
+    const Measurement* fastest = nullptr;
+    const Measurement* steadiest = nullptr;
+    for (const Measurement& m : measurements) {
+        if (m.workload != &workload) continue;
+        if (!m.ran) {
+            printf("%-5s %-19s did not run\n", m.server->name, m.server->architecture);
+            continue;
+        }
+        double commands = m.throughput * duration;
+        printf("%-5s %-19s %10.0f %9.3f %9.3f %9.3f %9.3f %8.2f %9.2f %10ld %10ld %8.1f %6ld\n",
+               m.server->name, m.server->architecture, m.throughput, m.p50, m.p99, m.p999, m.max, m.cpuSeconds,
+               commands > 0 ? m.cpuSeconds * 1e6 / commands : 0.0, m.voluntarySwitches, m.involuntarySwitches,
+               m.maxRssMb, m.lost);
+        if (m.failedConnections > 0) {
+            printf("      (took only %d of %d connections)\n", m.workload->connections - m.failedConnections,
+                   m.workload->connections);
+        }
+        if (!fastest || m.throughput > fastest->throughput) fastest = &m;
+        if (!steadiest || m.p99 < steadiest->p99) steadiest = &m;
+    }
+    // At a fixed rate every server that keeps up has the same throughput
+    if (fastest && workload.rate == 0) {
+        printf("Most throughput: %s; lowest p99: %s\n", fastest->server->name, steadiest->server->name);
+    } else if (steadiest) {
+        printf("Lowest p99: %s\n", steadiest->server->name);
+    }
+}
+
+static void writeCsv(const char* path, const std::vector<Measurement>& measurements, double duration) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        perror(path);
+        return;
+    }
+    fprintf(file, "workload,server,architecture,duration_s,commands_per_s,p50_ms,p99_ms,p999_ms,max_ms,"
+                  "cpu_s,voluntary_cs,involuntary_cs,max_rss_mb,lost,failed_connections\n");
+    for (const Measurement& m : measurements) {
+        if (!m.ran) continue;
+        fprintf(file, "%s,%s,%s,%.1f,%.0f,%.4f,%.4f,%.4f,%.4f,%.3f,%ld,%ld,%.1f,%ld,%d\n", m.workload->name,
+                m.server->name, m.server->architecture, duration, m.throughput, m.p50, m.p99, m.p999, m.max,
+                m.cpuSeconds, m.voluntarySwitches, m.involuntarySwitches, m.maxRssMb, m.lost, m.failedConnections);
+    }
+    fclose(file);
+}
+
+// Whether name is in the comma-separated list (an empty list takes everything)
+static bool selected(const std::string& list, const char* name) {
+    if (list.empty()) return true;
+    std::string padded = "," + list + ",";
+    return padded.find("," + std::string(name) + ",") != std::string::npos;
+}
+
+int main(int argc, char* argv[]) {
+    std::string root = "..";
+    double duration = 5;
+    std::string serverList, workloadList;
+    const char* csvPath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char* option = argv[i];
+        const char* value = i + 1 < argc ? argv[++i] : nullptr;
+        if (!value) {
+            std::cerr << "Missing value for " << option << std::endl;
+            return 1;
+        }
+        if (strcmp(option, "--root") == 0) {
+            root = value;
+        } else if (strcmp(option, "--duration") == 0) {
+            duration = atof(value);
+        } else if (strcmp(option, "--servers") == 0) {
+            serverList = value;
+        } else if (strcmp(option, "--workloads") == 0) {
+            workloadList = value;
+        } else if (strcmp(option, "--csv") == 0) {
+            csvPath = value;
+        } else {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+    if (duration <= 0) {
+        std::cerr << "Duration must be positive" << std::endl;
+        return 1;
+    }
+
+    std::vector<Measurement> measurements;
+    for (const Workload& workload : workloads) {
+        if (!selected(workloadList, workload.name)) continue;
+        for (const Server& server : servers) {
+            if (!selected(serverList, server.name)) continue;
+            Measurement m = Measurement();
+            m.server = &server;
+            m.workload = &workload;
+            std::cerr << "Running " << workload.name << " on " << server.name << std::endl;
+            runMeasurement(root, duration, m);
+            measurements.push_back(m);
+        }
+    }
+    if (measurements.empty()) {
+        std::cerr << "No such servers or workloads" << std::endl;
+        return 1;
+    }
+
+    printf("Server shootout on 127.0.0.1:%d; latency from the due time, server resources from rusage\n", PORT);
+    for (const Workload& workload : workloads) {
+        if (selected(workloadList, workload.name)) printWorkload(workload, measurements, duration);
+    }
+    if (csvPath) writeCsv(csvPath, measurements, duration);
+    return 0;
+}
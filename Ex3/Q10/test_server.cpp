@@ -0,0 +1,515 @@
+// Tests of the proactor server over its socket; run from Q10 with port 9034 free.
+// Each test starts its own ./convex_hull_server and stops it with SIGINT.
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#define PORT 9034
+#define START_TIMEOUT_MS 5000
+#define REPLY_TIMEOUT_MS 10000
+#define HULL_VERTICES 4000  // Below MAX_TRACKED_HULL, so hull changes go out as deltas
+#define FEED_ROUNDS 60      // Each replaces every vertex: about 12 MB of deltas in all
+#define HULL_POINTS 2000000 // Enough for a CH to still be sorting a little later
+#define MAX_GRAPHS 1024     // As in convex_hull.hpp
+
+static int connectToServer() {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in serverAddr;
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(PORT);
+    inet_pton(AF_INET, "127.0.0.1", &serverAddr.sin_addr);
+    if (connect(sock, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static pid_t startServer() {
+    pid_t pid = fork();
+    if (pid == 0) {
+        prctl(PR_SET_PDEATHSIG, SIGKILL); // A failed assert must not leave the port taken
+        int null = open("/dev/null", O_RDWR);
+        dup2(null, STDIN_FILENO);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        execl("./convex_hull_server", "convex_hull_server", static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    for (int waited = 0; waited < START_TIMEOUT_MS; waited += 20) {
+        int sock = connectToServer();
+        if (sock >= 0) {
+            close(sock);
+            return pid;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    std::cerr << "Server did not start listening on port " << PORT << std::endl;
+    kill(pid, SIGKILL);
+    exit(1);
+}
+
+// Whether the server is still running
+static bool serverAlive(pid_t pid) {
+    int status;
+    return waitpid(pid, &status, WNOHANG) == 0;
+}
+
+static void stopServer(pid_t pid) {
+    kill(pid, SIGINT);
+    int status;
+    for (int waited = 0; waited < START_TIMEOUT_MS; waited += 20) {
+        if (waitpid(pid, &status, WNOHANG) == pid) return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, &status, 0);
+}
+
+static void sendAll(int sock, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(sock, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        assert(n > 0);
+        sent += n;
+    }
+}
+
+// Next reply line without its newline; false on timeout or disconnect
+static bool readLine(int sock, std::string& line) {
+    line.clear();
+    while (true) {
+        struct pollfd pfd = {sock, POLLIN, 0};
+        if (poll(&pfd, 1, REPLY_TIMEOUT_MS) <= 0) return false;
+        char c;
+        if (recv(sock, &c, 1, 0) != 1) return false;
+        if (c == '\n') return true;
+        line += c;
+    }
+}
+
+static bool startsWith(const std::string& line, const char* prefix) {
+    return line.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// Connects and reads the command banner
+static int connectClient() {
+    int sock = connectToServer();
+    assert(sock >= 0);
+    std::string line;
+    bool banner = readLine(sock, line);
+    assert(banner && startsWith(line, "Commands:"));
+    return sock;
+}
+
+// Sends a command and returns its first reply line
+static std::string request(int sock, const std::string& command) {
+    sendAll(sock, command + "\n");
+    std::string line;
+    bool answered = readLine(sock, line);
+    assert(answered);
+    return line;
+}
+
+// Exactly len bytes; false on timeout or disconnect
+static bool readBytes(int sock, char* data, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        struct pollfd pfd = {sock, POLLIN, 0};
+        if (poll(&pfd, 1, REPLY_TIMEOUT_MS) <= 0) return false;
+        ssize_t n = recv(sock, data + got, len - got, 0);
+        if (n <= 0) return false;
+        got += n;
+    }
+    return true;
+}
+
+static void putLE(std::string& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) out += static_cast<char>(value >> (8 * i));
+}
+
+static uint64_t getLE(const char* data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    return value;
+}
+
+// u32 length | u8 opcode | payload
+static std::string binaryRequest(uint8_t opcode, const std::string& payload) {
+    std::string frame;
+    putLE(frame, payload.size() + 1, 4);
+    frame += static_cast<char>(opcode);
+    frame += payload;
+    return frame;
+}
+
+// Reads a response frame; returns its status and leaves its payload in payload
+static int binaryResponse(int sock, std::string& payload) {
+    char header[4];
+    bool got = readBytes(sock, header, 4);
+    assert(got);
+    uint32_t length = static_cast<uint32_t>(getLE(header, 4));
+    assert(length >= 2);
+    std::string body(length, '\0');
+    got = readBytes(sock, &body[0], length);
+    assert(got);
+    payload = body.substr(2);
+    return static_cast<unsigned char>(body[1]);
+}
+
+void testBinaryNaN() {
+    std::cout << "\n=== Testing binary frames with NaN points ===" << std::endl;
+    pid_t server = startServer();
+    int sock = connectClient();
+
+    sendAll(sock, std::string("\0CHB\1", 5));
+    std::string payload;
+    int status = binaryResponse(sock, payload);
+    assert(status == 0);
+
+    // OP_NEWPOINT with one float64 point (NaN, 1)
+    double coordinates[2] = {std::nan(""), 1.0};
+    std::string points;
+    for (double c : coordinates) {
+        uint64_t bits;
+        memcpy(&bits, &c, sizeof(bits));
+        putLE(points, bits, 8);
+    }
+    sendAll(sock, binaryRequest(0x03, points));
+    status = binaryResponse(sock, payload);
+    assert(status == 2); // STATUS_BAD_REQUEST
+    std::cout << "✓ NaN point rejected" << std::endl;
+
+    // The graph is untouched and a CH still works
+    sendAll(sock, binaryRequest(0x05, ""));
+    status = binaryResponse(sock, payload);
+    assert(status == 0 && payload.size() == 8 && getLE(payload.data(), 8) == 0);
+    sendAll(sock, binaryRequest(0x02, ""));
+    status = binaryResponse(sock, payload);
+    assert(status == 0);
+    std::cout << "✓ Graph unchanged" << std::endl;
+
+    // A frame announcing a gigabyte is malformed: the server hangs up instead of buffering it
+    std::string huge;
+    putLE(huge, 1u << 30, 4);
+    huge += static_cast<char>(0x01);
+    sendAll(sock, huge);
+    char byte;
+    bool more = readBytes(sock, &byte, 1);
+    assert(!more);
+    assert(serverAlive(server));
+    std::cout << "✓ Oversized frame refused" << std::endl;
+
+    close(sock);
+    stopServer(server);
+}
+
+void testOverflowingArea() {
+    std::cout << "\n=== Testing a hull whose area overflows ===" << std::endl;
+    pid_t server = startServer();
+    int sock = connectClient();
+
+    // The default graph carries the built-in area watch
+    std::string line = request(sock, "Newgraph 3");
+    assert(startsWith(line, "Ready for 3 points"));
+    request(sock, "1e308,0");
+    request(sock, "0,1e308");
+    request(sock, "-1e308,-1e308");
+    line = request(sock, "CH");
+    assert(startsWith(line, "Convex Hull Area:"));
+    line = request(sock, "Status");
+    assert(line == "Current graph has 3 points");
+    assert(serverAlive(server));
+    std::cout << "✓ Non-finite hull metrics leave the watches alone" << std::endl;
+
+    close(sock);
+    stopServer(server);
+}
+
+// Reads until text arrives; false on a timeout or disconnect first
+static bool readUntil(int sock, const std::string& text, int timeoutMs) {
+    std::string seen;
+    char buffer[65536];
+    while (true) {
+        struct pollfd pfd = {sock, POLLIN, 0};
+        if (poll(&pfd, 1, timeoutMs) <= 0) return false;
+        ssize_t n = recv(sock, buffer, sizeof(buffer), 0);
+        if (n <= 0) return false;
+        seen.append(buffer, n);
+        if (seen.find(text) != std::string::npos) return true;
+        // Keep only what a match across two reads needs
+        if (seen.size() > text.size()) seen.erase(0, seen.size() - text.size());
+    }
+}
+
+// Reads and drops whatever arrives until the socket is quiet for quietMs
+static void drain(int sock, int quietMs) {
+    char buffer[65536];
+    while (true) {
+        struct pollfd pfd = {sock, POLLIN, 0};
+        if (poll(&pfd, 1, quietMs) <= 0) return;
+        if (recv(sock, buffer, sizeof(buffer), 0) <= 0) return;
+    }
+}
+
+// Replaces the graph with HULL_VERTICES points on a circle, turned by phase
+static void loadCircle(int sock, double phase) {
+    std::string load = "Loadpoints " + std::to_string(HULL_VERTICES) + "\n";
+    char point[64];
+    for (int i = 0; i < HULL_VERTICES; i++) {
+        double angle = 2 * M_PI * (i + phase) / HULL_VERTICES;
+        snprintf(point, sizeof(point), "%.3f,%.3f\n", 1e6 * cos(angle), 1e6 * sin(angle));
+        load += point;
+    }
+    sendAll(sock, load);
+    std::string line;
+    bool loaded = readLine(sock, line);
+    assert(loaded && startsWith(line, "Graph loaded with"));
+}
+
+void testStalledSubscriber() {
+    std::cout << "\n=== Testing a hull subscriber that stops reading ===" << std::endl;
+    pid_t server = startServer();
+
+    int stalled = connectClient();
+    std::string line = request(stalled, "Subscribe hull");
+    assert(startsWith(line, "Hull "));
+
+    // Far more deltas than the socket buffers and the push backlog together hold
+    int writer = connectClient();
+    for (int round = 0; round < FEED_ROUNDS; round++) {
+        loadCircle(writer, round % 2 ? 0.5 : 0.0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    // Publishing the hull goes through the feed the stalled client is behind on
+    line = request(writer, "Watch area >= 1");
+    assert(startsWith(line, "Watch "));
+    std::cout << "✓ Other clients are served while a subscriber stalls" << std::endl;
+
+    // The stalled client gets what was queued for it, then a fresh snapshot
+    drain(stalled, 500);
+    loadCircle(writer, 0.25);
+    bool resynced = readUntil(stalled, " snapshot seq ", REPLY_TIMEOUT_MS);
+    assert(resynced);
+    assert(serverAlive(server));
+    std::cout << "✓ The subscriber skipped deltas and resynced" << std::endl;
+
+    close(stalled);
+    close(writer);
+    stopServer(server);
+}
+
+// Lines of a Stats reply
+static std::string stats(int sock) {
+    std::string line = request(sock, "Stats");
+    assert(startsWith(line, "Stats: "));
+    int count = atoi(line.c_str() + 7);
+    std::string body;
+    for (int i = 0; i < count; i++) {
+        bool got = readLine(sock, line);
+        assert(got);
+        body += line + "\n";
+    }
+    return body;
+}
+
+// Replaces the graph with HULL_POINTS scattered points
+static void loadLargeGraph(int sock) {
+    std::string load = "Loadpoints " + std::to_string(HULL_POINTS) + "\n";
+    char point[48];
+    for (long i = 0; i < HULL_POINTS; i++) {
+        snprintf(point, sizeof(point), "%ld,%ld\n", i % 9973, (i * 7919) % 10007);
+        load += point;
+    }
+    sendAll(sock, load);
+    std::string line;
+    bool loaded = readLine(sock, line);
+    assert(loaded && startsWith(line, "Graph loaded with"));
+}
+
+void testCloseDuringHull() {
+    std::cout << "\n=== Testing a client that closes during CH ===" << std::endl;
+    pid_t server = startServer();
+
+    int sock = connectClient();
+    loadLargeGraph(sock);
+
+    // A plain close: the server sees a FIN, not a reset
+    sendAll(sock, "CH\n");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    close(sock);
+
+    // Once the CH command is over, it must not have got past sorting
+    int other = connectClient();
+    std::string report;
+    for (int waited = 0; report.find("command CH:") == std::string::npos; waited += 20) {
+        assert(waited < REPLY_TIMEOUT_MS);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        report = stats(other);
+    }
+    assert(report.find("hull scan:") == std::string::npos);
+    std::cout << "✓ The hull stopped when its client left" << std::endl;
+
+    close(other);
+    stopServer(server);
+}
+
+void testAsyncLimits() {
+    std::cout << "\n=== Testing CHAsync limits ===" << std::endl;
+    pid_t server = startServer();
+
+    // Nothing watches big, so no hull of it is cached
+    int sock = connectClient();
+    std::string line = request(sock, "Use big");
+    assert(startsWith(line, "Using graph big"));
+    loadLargeGraph(sock);
+
+    // In one batch, so none of the hulls can finish before the last request
+    sendAll(sock, "CHAsync\nCHAsync\nCHAsync\nCHAsync\nCHAsync\n");
+    long tickets[4];
+    for (long& ticket : tickets) {
+        bool got = readLine(sock, line);
+        assert(got && startsWith(line, "CH ticket ") && line.find(" started") != std::string::npos);
+        ticket = atol(line.c_str() + 10);
+    }
+    bool got = readLine(sock, line);
+    assert(got && startsWith(line, "Busy: "));
+    std::cout << "✓ A connection's fifth running hull is refused" << std::endl;
+
+    // Another connection can neither cancel nor read them
+    int other = connectClient();
+    line = request(other, "CHCancel " + std::to_string(tickets[0]));
+    assert(startsWith(line, "Unknown CH ticket "));
+    line = request(other, "CHResult " + std::to_string(tickets[0]));
+    assert(startsWith(line, "Unknown CH ticket "));
+    close(other);
+    std::cout << "✓ Tickets belong to the connection that started them" << std::endl;
+
+    // Each cancel is answered, and each job pushes its result as it stops
+    for (long ticket : tickets) sendAll(sock, "CHCancel " + std::to_string(ticket) + "\n");
+    for (int results = 0; results < 4;) {
+        got = readLine(sock, line);
+        assert(got);
+        if (line.find(" cancelled after ") != std::string::npos || line.find(" done.") != std::string::npos) results++;
+    }
+    line = request(sock, "CHAsync");
+    assert(startsWith(line, "CH ticket ") && line.find(" started") != std::string::npos);
+    std::cout << "✓ Finished hulls free their slots" << std::endl;
+
+    close(sock);
+    stopServer(server);
+}
+
+void testGraphLimit() {
+    std::cout << "\n=== Testing the graph limit ===" << std::endl;
+    pid_t server = startServer();
+    int sock = connectClient();
+
+    // The default graph is one of them
+    std::string uses;
+    for (int i = 1; i < MAX_GRAPHS; i++) uses += "Use g" + std::to_string(i) + "\n";
+    sendAll(sock, uses);
+    std::string line;
+    for (int i = 1; i < MAX_GRAPHS; i++) {
+        bool got = readLine(sock, line);
+        assert(got && startsWith(line, "Using graph g"));
+    }
+    line = request(sock, "Use extra");
+    assert(startsWith(line, "Too many graphs"));
+    line = request(sock, "Newgraph extra 3");
+    assert(startsWith(line, "Too many graphs"));
+    std::cout << "✓ No graph is created past MAX_GRAPHS" << std::endl;
+
+    // The connection stays on its last graph, and existing graphs can still be used
+    line = request(sock, "Newgraph 3");
+    assert(line == "Ready for 3 points. Send points one by one.");
+    line = request(sock, "Use default");
+    assert(startsWith(line, "Using graph default"));
+    std::cout << "✓ Existing graphs stay usable" << std::endl;
+
+    close(sock);
+    stopServer(server);
+}
+
+void testBye() {
+    std::cout << "\n=== Testing Bye ===" << std::endl;
+    pid_t server = startServer();
+    int sock = connectClient();
+
+    // Everything before Bye is answered, then the server closes
+    sendAll(sock, "Newgraph 3\n0,0\n4,0\n0,4\nCH\nBye\nStatus\n");
+    std::string line;
+    for (int i = 0; i < 4; i++) {
+        bool got = readLine(sock, line);
+        assert(got);
+    }
+    bool got = readLine(sock, line);
+    assert(got && line == "Convex Hull Area: 8.0");
+    got = readLine(sock, line);
+    assert(got && line == "Bye");
+    got = readLine(sock, line);
+    assert(!got);
+    std::cout << "✓ Bye closes the connection after the replies before it" << std::endl;
+
+    close(sock);
+    stopServer(server);
+}
+
+void testWatchInitialState() {
+    std::cout << "\n=== Testing the initial state of a watch ===" << std::endl;
+    pid_t server = startServer();
+    int sock = connectClient();
+
+    // Nothing watches g, so its points only extend the cached hull
+    std::string line = request(sock, "Newgraph g 4");
+    assert(startsWith(line, "Ready for 4 points"));
+    request(sock, "0,0");
+    request(sock, "10,0");
+    request(sock, "10,10");
+    request(sock, "0,10");
+    line = request(sock, "Watch area >= 10");
+    assert(line.find("(currently true)") != std::string::npos);
+    line = request(sock, "Watch area < 10");
+    assert(line.find("(currently false)") != std::string::npos);
+    std::cout << "✓ A new watch starts from the graph's current hull" << std::endl;
+
+    // Nothing changed, so no notification follows
+    struct pollfd pfd = {sock, POLLIN, 0};
+    int pending = poll(&pfd, 1, 200);
+    assert(pending == 0);
+    std::cout << "✓ No notification for a state the reply already gave" << std::endl;
+
+    close(sock);
+    stopServer(server);
+}
+
+int main() {
+    std::cout << "Starting server tests..." << std::endl;
+    testOverflowingArea();
+    testBinaryNaN();
+    testWatchInitialState();
+    testStalledSubscriber();
+    testCloseDuringHull();
+    testAsyncLimits();
+    testGraphLimit();
+    testBye();
+    std::cout << "\n=== All server tests completed ===" << std::endl;
+    return 0;
+}
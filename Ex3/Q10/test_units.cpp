@@ -0,0 +1,376 @@
+// Unit tests of the server's pure helpers, linked against its own code
+// ("make run"). The socket-level behaviour is for test_server.cpp.
+#include "convex_hull.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+// Bitwise equal, so -0.0 and 0.0 differ
+static bool sameDouble(double a, double b) {
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// parseDouble must agree with strtod on value and on where the number ends
+static void checkParse(const std::string& text) {
+    double expected, parsed = 0.0;
+    char* stop;
+    expected = strtod(text.c_str(), &stop);
+    const char* end = parseDouble(text.data(), text.data() + text.size(), parsed);
+    if (stop == text.c_str() || !std::isfinite(expected)) {
+        if (end) std::cerr << "accepted \"" << text << "\"" << std::endl;
+        assert(!end);
+        return;
+    }
+    if (!end || end != text.data() + (stop - text.c_str()) || !sameDouble(parsed, expected)) {
+        std::cerr << "\"" << text << "\": parsed " << parsed << ", strtod " << expected << std::endl;
+    }
+    assert(end == text.data() + (stop - text.c_str()));
+    assert(sameDouble(parsed, expected));
+}
+
+// Random decimal text: digits, maybe a point, maybe an exponent
+static std::string randomNumber(std::mt19937_64& rng) {
+    std::string text;
+    if (rng() % 3 == 0) text += rng() % 2 ? '-' : '+';
+    int digits = 1 + rng() % 30;
+    int point = rng() % 2 ? static_cast<int>(rng() % (digits + 1)) : -1;
+    for (int i = 0; i < digits; i++) {
+        if (i == point) text += '.';
+        text += static_cast<char>('0' + rng() % 10);
+    }
+    if (rng() % 2) {
+        text += rng() % 2 ? 'e' : 'E';
+        int exponent = static_cast<int>(rng() % 661) - 330;
+        text += std::to_string(exponent);
+    }
+    return text;
+}
+
+void testParseDouble() {
+    std::cout << "\n=== Testing parseDouble against strtod ===" << std::endl;
+
+    const char* cases[] = {
+        "0", "-0", "+0", "0.0", "-0.0", "1", "-1", "0.1", "0.5", ".5", "5.", "-.25",
+        "123.456", "1e22", "1e23", "1E-22", "1e-23", "2.5e+3", "7e0",
+        // Exponent markers with nothing behind them end the number before the marker
+        "1e", "1e+", "3.5E-", "2ex",
+        // Longer than the fast path's 19 digits, or past 2^53
+        "9007199254740992", "9007199254740993", "9007199254740995", "18446744073709551615",
+        "123456789012345678901234567890", "0.1000000000000000055511151231257827",
+        "3.14159265358979323846264338327950288",
+        "00000000000000000000000000000000000001.5", "1.00000000000000000000000000000000001",
+        // Ties between two doubles round to even
+        "9007199254740993.0", "4503599627370497.5", "0.30000000000000004", "2.0000000000000002220446049250313",
+        // The limits of double
+        "1.7976931348623157e308", "1.7976931348623159e308", "2.2250738585072014e-308",
+        "2.2250738585072011e-308", "4.9406564584124654e-324", "2e-324", "1e-400", "1e400", "-1e309",
+        // Whitespace before, not after
+        "  42", "\t-3.5", "12 34", "1,2",
+        // Not numbers
+        "", " ", "-", "+", ".", "e5", "-.e1", "x1", ",3",
+    };
+    for (const char* text : cases) checkParse(text);
+    std::cout << "✓ Fixed cases match strtod" << std::endl;
+
+    std::mt19937_64 rng(20240531);
+    char text[64];
+    for (int i = 0; i < 200000; i++) {
+        checkParse(randomNumber(rng));
+        // What clients usually send: printf output of random doubles
+        double value = std::ldexp(static_cast<double>(rng() >> 11), static_cast<int>(rng() % 120) - 80);
+        if (rng() % 2) value = -value;
+        snprintf(text, sizeof(text), rng() % 2 ? "%.17g" : "%.6f", value);
+        checkParse(text);
+    }
+    std::cout << "✓ Random numbers match strtod" << std::endl;
+}
+
+// Parses text as a point; the parse stays outside assert() for -DNDEBUG builds
+static bool pointIs(const char* begin, const char* end, double x, double y) {
+    Point point;
+    bool parsed = parsePoint(begin, end, point);
+    return parsed && point.x == x && point.y == y;
+}
+
+static bool pointIs(const char* text, double x, double y) {
+    return pointIs(text, text + strlen(text), x, y);
+}
+
+void testParsePoint() {
+    std::cout << "\n=== Testing parsePoint ===" << std::endl;
+
+    bool ok = pointIs("1.5,-2", 1.5, -2) && pointIs(" 3 , 4 ", 3, 4) && pointIs("1e3,2E-1", 1000, 0.2);
+    assert(ok);
+
+    const char* malformed[] = {"", "1", "1,", ",1", "1 2", "1,2,3", "1,2x", "a,b", "1;2", "1e400,0"};
+    for (const char* text : malformed) {
+        Point point;
+        bool parsed = parsePoint(std::string(text), point);
+        assert(!parsed);
+        (void)parsed;
+    }
+
+    // The range form stops at end, wherever the text goes on; a newline is whitespace
+    const char* line = "5,6\n7,8";
+    ok = pointIs(line, line + 3, 5, 6) && pointIs(line, line + 4, 5, 6) && !pointIs(line, line + 5, 5, 6);
+    assert(ok);
+    (void)ok;
+    std::cout << "✓ Points parse and malformed ones are refused" << std::endl;
+}
+
+// Whitespace-separated "x,y" tokens, with some malformed ones among them
+static std::vector<std::string> randomTokens(std::mt19937_64& rng, size_t count) {
+    std::vector<std::string> tokens;
+    char text[128];
+    for (size_t i = 0; i < count; i++) {
+        switch (rng() % 8) {
+        case 0:
+            tokens.push_back(rng() % 2 ? "1,x" : "7");
+            break;
+        case 1:
+            // Long enough to cross a window on its own
+            snprintf(text, sizeof(text), "%.40f,%.17g", static_cast<double>(rng() % 1000) / 7, -1e-3 * (rng() % 997));
+            tokens.push_back(text);
+            break;
+        default:
+            snprintf(text, sizeof(text), "%d,%d.%d", static_cast<int>(rng() % 2001) - 1000,
+                     static_cast<int>(rng() % 100), static_cast<int>(rng() % 10));
+            tokens.push_back(text);
+        }
+    }
+    return tokens;
+}
+
+// Feeds the payload to scanPoints in pieces of random size, the way reads arrive,
+// and checks the points against parsing each token on its own
+static void checkScan(std::mt19937_64& rng, const std::string& payload,
+                      const std::vector<std::string>& tokens, size_t maxPiece) {
+    std::vector<Point> expected;
+    bool expectInvalid = false;
+    for (const std::string& token : tokens) {
+        Point point;
+        if (parsePoint(token, point)) {
+            expected.push_back(point);
+        } else {
+            expectInvalid = true;
+        }
+    }
+
+    long pending = static_cast<long>(tokens.size());
+    std::vector<Point> points;
+    bool invalid = false;
+    size_t pos = 0, received = 0;
+    while (received < payload.size()) {
+        received = std::min(payload.size(), received + 1 + rng() % maxPiece);
+        pos += scanPoints(payload.data() + pos, payload.data() + received, pending, points, invalid);
+        assert(pos <= received);
+    }
+
+    bool same = pending == 0 && invalid == expectInvalid && points.size() == expected.size();
+    for (size_t i = 0; same && i < points.size(); i++) {
+        same = sameDouble(points[i].x, expected[i].x) && sameDouble(points[i].y, expected[i].y);
+    }
+    if (!same) std::cerr << "scanPoints disagrees on \"" << payload << "\"" << std::endl;
+    assert(same);
+    (void)same;
+}
+
+void testScanPoints() {
+    std::cout << "\n=== Testing scanPoints ===" << std::endl;
+
+    // A token running into end is not counted until whitespace follows it
+    std::string text = "1,2 3,4";
+    long pending = 2;
+    std::vector<Point> points;
+    bool invalid = false;
+    size_t consumed = scanPoints(text.data(), text.data() + text.size(), pending, points, invalid);
+    bool ok = consumed == 3 && pending == 1 && points.size() == 1 && !invalid;
+    text += "\n";
+    consumed += scanPoints(text.data() + consumed, text.data() + text.size(), pending, points, invalid);
+    ok = ok && consumed == 7 && pending == 0 && points.size() == 2 && points[1].x == 3 && points[1].y == 4;
+    assert(ok);
+
+    // Only pending tokens are taken; the rest of the buffer is left alone
+    text = "1,1 2,2 3,3 ";
+    pending = 2;
+    points.clear();
+    consumed = scanPoints(text.data(), text.data() + text.size(), pending, points, invalid);
+    ok = consumed == 7 && pending == 0 && points.size() == 2;
+    assert(ok);
+    (void)ok;
+    std::cout << "✓ Tokens at the buffer end wait for the next read" << std::endl;
+
+    // Shift a token across each 16, 32 and 64-byte boundary of the SIMD windows
+    std::mt19937_64 rng(20240601);
+    for (size_t lead = 0; lead < 130; lead++) {
+        std::vector<std::string> tokens = {"12.5,-3", "4,5"};
+        std::string payload(lead, ' ');
+        payload += tokens[0] + "\r\n" + tokens[1] + "\t\n";
+        checkScan(rng, payload, tokens, payload.size());
+        checkScan(rng, payload, tokens, 7);
+    }
+    std::cout << "✓ Tokens straddling window boundaries are found" << std::endl;
+
+    // Random payloads with whitespace runs of every kind and length, read in pieces
+    const char spaces[] = " \t\n\v\f\r";
+    for (int i = 0; i < 3000; i++) {
+        std::vector<std::string> tokens = randomTokens(rng, 1 + rng() % 40);
+        std::string payload;
+        for (const std::string& token : tokens) {
+            size_t run = rng() % 4 ? 1 : 1 + rng() % 70;
+            for (size_t j = 0; j < run; j++) payload += spaces[rng() % 6];
+            payload += token;
+        }
+        payload += '\n';
+        checkScan(rng, payload, tokens, 1 + rng() % 200);
+    }
+    std::cout << "✓ Random payloads match token-by-token parsing" << std::endl;
+}
+
+static double decimalScale(int decimals) {
+    double scale = 1;
+    while (decimals-- > 0) scale *= 10;
+    return scale;
+}
+
+// appendFixed must write exactly what printf("%.*f") writes
+static void checkFixed(double value, int decimals) {
+    char expected[512];
+    snprintf(expected, sizeof(expected), "%.*f", decimals, value);
+    std::string out = "prefix";
+    appendFixed(out, value, decimals);
+    if (out != std::string("prefix") + expected) {
+        std::cerr << "%." << decimals << "f of " << value << ": \"" << out.substr(6)
+                  << "\", printf \"" << expected << "\"" << std::endl;
+    }
+    assert(out == std::string("prefix") + expected);
+}
+
+void testAppendFixed() {
+    std::cout << "\n=== Testing appendFixed against printf ===" << std::endl;
+
+    const double cases[] = {
+        0.0, -0.0, 1.0, -1.0, 0.5, -0.5, 1.5, 2.5, 0.125, -0.0000001, 0.0000005, 0.0000015,
+        // Carries through every digit
+        9.9999995, 9.99999949, 99.9999996, -9.9999995, 0.9999999, 999999.9999999,
+        // Near and past the 1e12 fast-path limit, and beyond 2^64
+        999999.999999, 1e6, 123456789.123456, 1e12, 4503599627370495.5, 1e19, 1.8446744073709552e19, 1e300,
+        -1e300, 5e-324, 2.2250738585072014e-308,
+        std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::quiet_NaN(),
+    };
+    for (double value : cases) {
+        for (int decimals = 0; decimals <= 8; decimals++) checkFixed(value, decimals);
+    }
+    std::cout << "✓ Fixed cases match printf" << std::endl;
+
+    std::mt19937_64 rng(20240602);
+    for (int i = 0; i < 300000; i++) {
+        double value;
+        switch (rng() % 3) {
+        case 0:
+            // Random bits over the whole range that reaches the fast path
+            value = std::ldexp(static_cast<double>(rng() >> 11), static_cast<int>(rng() % 90) - 90);
+            break;
+        case 1:
+            // Coordinates as clients send them, right at the rounding digit
+            value = static_cast<double>(static_cast<long>(rng() % 2000000001) - 1000000000) / 1e7;
+            break;
+        default:
+            // Ties and near-ties of the last printed digit
+            value = (static_cast<double>(rng() % 100000000) + 0.5) / decimalScale(rng() % 7);
+        }
+        if (rng() % 2) value = -value;
+        checkFixed(value, static_cast<int>(rng() % 7));
+    }
+    std::cout << "✓ Random values match printf" << std::endl;
+
+    std::string out;
+    appendInt(out, 0);
+    out += ' ';
+    appendInt(out, -42);
+    out += ' ';
+    appendInt(out, std::numeric_limits<long long>::min());
+    out += ' ';
+    appendPoint(out, Point(-1.5, 1e7 / 3));
+    assert(out == "0 -42 -9223372036854775808 (" + std::to_string(-1.5) + "," + std::to_string(1e7 / 3) + ")");
+    std::cout << "✓ appendInt and appendPoint match std::to_string" << std::endl;
+}
+
+// The hull's vertices in sorted order, so hulls starting at different vertices compare equal
+static std::vector<Point> sortedVertices(std::vector<Point> hull) {
+    std::sort(hull.begin(), hull.end());
+    return hull;
+}
+
+void testExtendHull() {
+    std::cout << "\n=== Testing extendHull against a full recompute ===" << std::endl;
+
+    std::vector<Point> square = convexHull({Point(0, 0), Point(4, 0), Point(4, 4), Point(0, 4)});
+    bool ok = insideHull(square, Point(2, 2)) && insideHull(square, Point(4, 2)) &&
+              insideHull(square, Point(0, 0)) && !insideHull(square, Point(5, 2)) &&
+              !insideHull(square, Point(-0.001, 2));
+    assert(ok);
+    (void)ok;
+    std::cout << "✓ insideHull counts the boundary as inside" << std::endl;
+
+    // Small integer grids make duplicates and collinear points on the hull common,
+    // and keep every cross product exact
+    std::mt19937_64 rng(20240603);
+    for (int round = 0; round < 2000; round++) {
+        int range = 2 + static_cast<int>(rng() % 20);
+        std::vector<Point> points, hull;
+        int count = 1 + static_cast<int>(rng() % 60);
+        for (int i = 0; i < count; i++) {
+            Point p(static_cast<double>(rng() % range), static_cast<double>(rng() % range));
+            if (rng() % 4 == 0) p.y = p.x;     // On a diagonal
+            points.push_back(p);
+            std::vector<Point> before = hull;
+            bool changed = extendHull(hull, p);
+
+            bool same = sortedVertices(hull) == sortedVertices(convexHull(points));
+            if (!same) std::cerr << "extendHull differs after " << points.size() << " points" << std::endl;
+            assert(same);
+            // false promises the hull is untouched
+            bool honest = changed || hull == before;
+            assert(honest);
+            (void)same;
+            (void)honest;
+        }
+    }
+    std::cout << "✓ Random appends keep the hull of every prefix" << std::endl;
+
+    // Random doubles: same vertices as a recompute
+    for (int round = 0; round < 200; round++) {
+        std::vector<Point> points, hull;
+        std::uniform_real_distribution<double> coordinate(-1000, 1000);
+        for (int i = 0; i < 500; i++) {
+            points.push_back(Point(coordinate(rng), coordinate(rng)));
+            extendHull(hull, points.back());
+        }
+        bool same = sortedVertices(hull) == sortedVertices(convexHull(points));
+        assert(same);
+        (void)same;
+    }
+    std::cout << "✓ Random real points give the recomputed hull" << std::endl;
+}
+
+int main() {
+    std::cout << "Starting unit tests..." << std::endl;
+    testParseDouble();
+    testParsePoint();
+    testScanPoints();
+    testAppendFixed();
+    testExtendHull();
+    std::cout << "\n=== All unit tests completed ===" << std::endl;
+    return 0;
+}
@@ -0,0 +1,244 @@
+#include "convex_hull.hpp"
+#include "watch.hpp"
+#include "logger.hpp"
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+static const char* metricNames[METRIC_COUNT] = {"area", "perimeter", "vertices"};
+
+double HullStats::value(WatchMetric metric) const {
+    switch (metric) {
+    case METRIC_AREA: return area;
+    case METRIC_PERIMETER: return perimeter;
+    default: return static_cast<double>(vertices);
+    }
+}
+
+// Whether the watch's predicate holds for value
+static bool watchHolds(const Watch& watch, double value) {
+    return (value >= watch.threshold) != watch.below;
+}
+
+static bool tokenIs(const Token& token, const char* word) {
+    size_t length = token.end - token.begin;
+    return length == strlen(word) && memcmp(token.begin, word, length) == 0;
+}
+
+bool parseWatch(const char* args, const char* end, Watch& watch) {
+    Token metric = nextToken(args, end);
+    int m = 0;
+    while (m < METRIC_COUNT && !tokenIs(metric, metricNames[m])) m++;
+    if (m == METRIC_COUNT) return false;
+    watch.metric = static_cast<WatchMetric>(m);
+
+    Token op = nextToken(args, end);
+    if (tokenIs(op, ">=")) watch.below = false;
+    else if (tokenIs(op, "<")) watch.below = true;
+    else return false;
+
+    const char* p = parseDouble(args, end, watch.threshold);
+    if (!p || !std::isfinite(watch.threshold)) return false;
+    if (nextToken(p, end).begin != end) return false;
+    // Vertex counts are whole numbers, and so are their thresholds
+    return watch.metric != METRIC_VERTICES || watch.threshold == std::floor(watch.threshold);
+}
+
+unsigned long addWatch(WatchSet& set, const std::shared_ptr<Watch>& watch) {
+    std::lock_guard<InstrumentedMutex> lock(set.mutex);
+    watch->state = watchHolds(*watch, set.stats.value(watch->metric));
+    set.byThreshold[watch->metric].insert(std::make_pair(watch->threshold, watch));
+    set.count++;
+    return set.version;
+}
+
+bool removeWatch(WatchSet& set, const std::shared_ptr<Watch>& watch) {
+    std::lock_guard<InstrumentedMutex> lock(set.mutex);
+    auto& sorted = set.byThreshold[watch->metric];
+    auto range = sorted.equal_range(watch->threshold);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == watch) {
+            sorted.erase(it);
+            set.count--;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Line telling the watch's owner that its predicate changed. The built-in
+// watch has no owner and logs the line instead
+static std::string watchNotice(const Watch& watch, double value) {
+    if (!watch.sink) {
+        // The assignment's "at least 100 units" messages
+        char text[64];
+        snprintf(text, sizeof(text), watch.state ? "At Least %g units belongs to CH" : "At Least %g units no longer belongs to CH",
+                 watch.threshold);
+        return text;
+    }
+    std::string line = "Watch ";
+    appendInt(line, watch.id);
+    line += ": ";
+    appendWatchPredicate(line, watch);
+    line += watch.state ? " is now true (" : " is now false (";
+    line += metricNames[watch.metric];
+    line += ' ';
+    appendMetricValue(line, watch.metric, value);
+    line += ")\n";
+    return line;
+}
+
+// Whether every metric of stats is a number (coordinates near the double
+// limit overflow the area to inf or NaN)
+static bool statsFinite(const HullStats& stats) {
+    return std::isfinite(stats.area) && std::isfinite(stats.perimeter);
+}
+
+void updateWatches(WatchSet& set, unsigned long version, const HullStats& stats) {
+    if (!statsFinite(stats)) {
+        logMessage(LOG_WARN, "Hull metrics overflowed; watches keep their state");
+        return;
+    }
+    std::unique_lock<InstrumentedMutex> lock(set.mutex);
+    if (version < set.version) return; // A newer hull was already published
+    HullStats old = set.stats;
+    set.stats = stats;
+    set.version = version;
+
+    // The notices are made under the lock and sent outside it, so adding a
+    // watch waits for no client. sendMutex keeps them in order meanwhile
+    std::unique_lock<std::mutex> sendLock(set.sendMutex);
+    std::vector<std::pair<std::shared_ptr<ClientSink>, std::string>> notices;
+    for (int m = 0; m < METRIC_COUNT; m++) {
+        // A predicate "value >= t" changes exactly when t lies in (low, high]
+        double before = old.value(static_cast<WatchMetric>(m));
+        double after = stats.value(static_cast<WatchMetric>(m));
+        if (before == after) continue;
+        double low = before < after ? before : after;
+        double high = before < after ? after : before;
+
+        auto& sorted = set.byThreshold[m];
+        auto last = sorted.upper_bound(high);
+        for (auto it = sorted.upper_bound(low); it != last && it != sorted.end(); ++it) {
+            Watch& watch = *it->second;
+            bool state = watchHolds(watch, after);
+            if (state == watch.state) continue;
+            watch.state = state;
+            notices.push_back(std::make_pair(watch.sink, watchNotice(watch, after)));
+        }
+    }
+    lock.unlock();
+
+    for (auto& notice : notices) {
+        if (notice.first) {
+            pushToClient(*notice.first, notice.second);
+        } else {
+            logMessage(LOG_INFO, "%s", notice.second.c_str());
+        }
+    }
+}
+
+void appendWatchPredicate(std::string& out, const Watch& watch) {
+    out += metricNames[watch.metric];
+    out += watch.below ? " < " : " >= ";
+    appendMetricValue(out, watch.metric, watch.threshold);
+}
+
+void appendMetricValue(std::string& out, WatchMetric metric, double value) {
+    if (metric == METRIC_VERTICES) {
+        appendInt(out, static_cast<long long>(value));
+    } else {
+        appendFixed(out, value, 1);
+    }
+}
+
+// Appends "Hull 3 snapshot seq 7: (x,y) (x,y) ..."
+static void appendHullSnapshot(std::string& out, const HullFeed& feed, const HullSubscription& subscription) {
+    out += "Hull ";
+    appendInt(out, subscription.id);
+    out += " snapshot seq ";
+    appendInt(out, feed.sequence);
+    out += ':';
+    for (const Point& vertex : feed.vertices) {
+        out += ' ';
+        appendPoint(out, vertex);
+    }
+}
+
+void subscribeHull(HullFeed& feed, const std::shared_ptr<HullSubscription>& subscription, std::string& out) {
+    std::lock_guard<std::mutex> lock(feed.mutex);
+    {
+        // Subscribing again is how a client resyncs
+        std::lock_guard<std::mutex> sendLock(feed.sendMutex);
+        subscription->stale = false;
+    }
+    if (std::find(feed.subscribers.begin(), feed.subscribers.end(), subscription) == feed.subscribers.end()) {
+        feed.subscribers.push_back(subscription);
+        feed.count++;
+    }
+    appendHullSnapshot(out, feed, *subscription);
+}
+
+bool unsubscribeHull(HullFeed& feed, const std::shared_ptr<HullSubscription>& subscription) {
+    std::lock_guard<std::mutex> lock(feed.mutex);
+    auto it = std::find(feed.subscribers.begin(), feed.subscribers.end(), subscription);
+    if (it == feed.subscribers.end()) return false;
+    feed.subscribers.erase(it);
+    feed.count--;
+    return true;
+}
+
+void updateHullFeed(HullFeed& feed, unsigned long version, const std::vector<Point>& hull) {
+    std::unique_lock<std::mutex> lock(feed.mutex);
+    if (version < feed.version) return;
+    feed.version = version;
+
+    // Vertices that came and went, found on sorted copies
+    std::vector<Point> before(feed.vertices), after(hull);
+    std::sort(before.begin(), before.end());
+    std::sort(after.begin(), after.end());
+    std::vector<Point> added, removed;
+    std::set_difference(after.begin(), after.end(), before.begin(), before.end(), std::back_inserter(added));
+    std::set_difference(before.begin(), before.end(), after.begin(), after.end(), std::back_inserter(removed));
+    if (added.empty() && removed.empty()) return;
+
+    feed.vertices = hull;
+    feed.sequence++;
+
+    std::string changes = " seq ";
+    appendInt(changes, feed.sequence);
+    changes += ':';
+    for (const Point& vertex : added) {
+        changes += " +";
+        appendPoint(changes, vertex);
+    }
+    for (const Point& vertex : removed) {
+        changes += " -";
+        appendPoint(changes, vertex);
+    }
+
+    // The lines are made under the lock and sent outside it, so subscribing
+    // waits for no client. sendMutex keeps the changes in order meanwhile
+    std::unique_lock<std::mutex> sendLock(feed.sendMutex);
+    std::vector<std::pair<std::shared_ptr<HullSubscription>, std::string>> lines;
+    lines.reserve(feed.subscribers.size());
+    for (auto& subscription : feed.subscribers) {
+        std::string line;
+        if (subscription->stale) {
+            appendHullSnapshot(line, feed, *subscription);
+        } else {
+            line += "Hull ";
+            appendInt(line, subscription->id);
+            line += changes;
+        }
+        line += '\n';
+        lines.push_back(std::make_pair(subscription, std::move(line)));
+    }
+    lock.unlock();
+
+    for (auto& entry : lines) {
+        // A client that cannot keep up skips this change and resyncs with the next
+        entry.first->stale = !offerToClient(*entry.first->sink, entry.second, MAX_PUSH_BACKLOG);
+    }
+}
@@ -0,0 +1,118 @@
+#ifndef WATCH_HPP
+#define WATCH_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include "server_stats.hpp"
+
+// Subscriptions on a graph's hull; included by convex_hull.hpp once Point is defined.
+//
+// Threshold watches.
+// A client registers "Watch area >= 100" (or "<", and perimeter or vertices
+// instead of area) and is told every time the predicate turns true or false.
+// Watches are kept sorted by threshold, so a hull update only visits the
+// watches whose threshold lies between the old and the new value.
+
+struct ClientSink;
+
+enum WatchMetric {
+    METRIC_AREA,
+    METRIC_PERIMETER,
+    METRIC_VERTICES,
+    METRIC_COUNT
+};
+
+// What the watches are evaluated against
+struct HullStats {
+    double area = 0.0;
+    double perimeter = 0.0;
+    size_t vertices = 0;
+
+    double value(WatchMetric metric) const;
+};
+
+// One Watch registration
+struct Watch {
+    unsigned long id = 0;
+    WatchMetric metric = METRIC_AREA;
+    bool below = false;               // "< threshold" rather than ">= threshold"
+    double threshold = 0.0;
+    bool state = false;               // Whether the predicate held at the last update
+    std::shared_ptr<ClientSink> sink; // Where to push; nullptr logs instead
+};
+
+// The watches on one graph, plus the hull they were last evaluated against
+struct WatchSet {
+    InstrumentedMutex mutex{LOCK_WATCHES}; // Guards the fields below
+    std::mutex sendMutex;           // Taken before mutex is released: one update notifies at a time, in order
+    HullStats stats;                // Hull of an empty graph until one is computed
+    unsigned long version = 0;      // Graph version stats belong to
+    std::multimap<double, std::shared_ptr<Watch>> byThreshold[METRIC_COUNT];
+    std::atomic<size_t> count{0};   // Registered watches; read without the mutex
+};
+
+// Parses "<metric> <op> <threshold>" (metric: area, perimeter or vertices;
+// op: >= or <) into watch; false if malformed
+bool parseWatch(const char* args, const char* end, Watch& watch);
+
+// Registers watch, setting its state from the set's current stats; returns
+// the graph version those belong to
+unsigned long addWatch(WatchSet& set, const std::shared_ptr<Watch>& watch);
+
+// Unregisters watch; false if it was not registered
+bool removeWatch(WatchSet& set, const std::shared_ptr<Watch>& watch);
+
+// Takes the hull of the graph at version and notifies every watch whose
+// predicate changed. Stats older than the ones already seen are ignored
+void updateWatches(WatchSet& set, unsigned long version, const HullStats& stats);
+
+// Appends "area >= 100.0"
+void appendWatchPredicate(std::string& out, const Watch& watch);
+
+// Appends the value of the watch's metric, formatted like its threshold
+void appendMetricValue(std::string& out, WatchMetric metric, double value);
+
+// Hull subscriptions ("Subscribe hull").
+// A subscriber first gets the hull's vertices, then one line per change
+// listing only the vertices that came and went, so the traffic follows the
+// hull's churn rather than its size. Every change has the next sequence
+// number; a subscriber whose client falls too far behind skips changes (a
+// gap in the numbers) and gets a fresh snapshot with the next one instead.
+//
+//   Hull 3 snapshot seq 7: (0.000000,0.000000) (4.000000,0.000000) ...
+//   Hull 3 seq 8: +(9.000000,9.000000) -(4.000000,4.000000)
+
+struct HullSubscription {
+    unsigned long id = 0;
+    std::shared_ptr<ClientSink> sink;
+    bool stale = false; // Missed a change; owed a snapshot. Guarded by the feed's sendMutex
+};
+
+// The hull subscribers of one graph and the hull they last saw
+struct HullFeed {
+    std::mutex mutex;               // Guards the fields below
+    std::mutex sendMutex;           // Taken before mutex is released: one change goes out at a time, in order
+    unsigned long version = 0;      // Graph version vertices belong to
+    unsigned long sequence = 0;     // Number of the last change to vertices
+    std::vector<Point> vertices;    // Counter-clockwise
+    std::vector<std::shared_ptr<HullSubscription>> subscribers;
+    std::atomic<size_t> count{0};   // Subscribers; read without the mutex
+};
+
+// Registers subscription (or keeps it, if it is registered already) and
+// appends a snapshot line to out; changes published later follow it
+void subscribeHull(HullFeed& feed, const std::shared_ptr<HullSubscription>& subscription, std::string& out);
+
+// Unregisters subscription; false if it was not registered
+bool unsubscribeHull(HullFeed& feed, const std::shared_ptr<HullSubscription>& subscription);
+
+// Takes the hull of the graph at version and sends the changed vertices to the
+// subscribers. Hulls older than the last one taken are ignored
+void updateHullFeed(HullFeed& feed, unsigned long version, const std::vector<Point>& hull);
+
+#endif // WATCH_HPP
@@ -0,0 +1,491 @@
+#include "benchmark_suite.hpp"
+#include "monotone_chain.hpp"
+#include "perf_counters.hpp"
+#include <iostream>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <type_traits>
+
+typedef void (*Generator)(std::mt19937_64& random, size_t n, std::vector<Point>& points);
+
+#define COORDINATE_RANGE 1000.0 // Inputs span [-1000, 1000] on both axes, except collinear
+
+static const double PI = 3.14159265358979323846;
+
+static void uniformSquare(std::mt19937_64& random, size_t n, std::vector<Point>& points) {
+    std::uniform_real_distribution<double> coordinate(-COORDINATE_RANGE, COORDINATE_RANGE);
+    for (size_t i = 0; i < n; i++) {
+        double x = coordinate(random);
+        points[i] = Point(x, coordinate(random));
+    }
+}
+
+static void uniformDisk(std::mt19937_64& random, size_t n, std::vector<Point>& points) {
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (size_t i = 0; i < n; i++) {
+        double r = COORDINATE_RANGE * std::sqrt(unit(random));
+        double angle = 2 * PI * unit(random);
+        points[i] = Point(r * std::cos(angle), r * std::sin(angle));
+    }
+}
+
+// Every point is a hull vertex (up to rounding): the worst case, h = n
+static void onCircle(std::mt19937_64& random, size_t n, std::vector<Point>& points) {
+    std::uniform_real_distribution<double> angles(0.0, 2 * PI);
+    for (size_t i = 0; i < n; i++) {
+        double angle = angles(random);
+        points[i] = Point(COORDINATE_RANGE * std::cos(angle), COORDINATE_RANGE * std::sin(angle));
+    }
+}
+
+static void gaussianClusters(std::mt19937_64& random, size_t n, std::vector<Point>& points) {
+    const int clusters = 8;
+    std::uniform_real_distribution<double> coordinate(-COORDINATE_RANGE, COORDINATE_RANGE);
+    std::normal_distribution<double> spread(0.0, COORDINATE_RANGE / 20);
+    Point centers[clusters];
+    for (int c = 0; c < clusters; c++) {
+        double x = coordinate(random);
+        centers[c] = Point(x, coordinate(random));
+    }
+    for (size_t i = 0; i < n; i++) {
+        const Point& center = centers[random() % clusters];
+        double dx = spread(random);
+        points[i] = Point(center.x + dx, center.y + spread(random));
+    }
+}
+
+// All on y = 2x + 1, with integer x so the line is exact. x spans [-1e6, 1e6],
+// so y reaches about 2e6: far beyond COORDINATE_RANGE
+static void collinear(std::mt19937_64& random, size_t n, std::vector<Point>& points) {
+    std::uniform_int_distribution<int> coordinate(-1000000, 1000000);
+    for (size_t i = 0; i < n; i++) {
+        double x = coordinate(random);
+        points[i] = Point(x, 2 * x + 1);
+    }
+}
+
+// 16 distinct points, each repeated about n / 16 times
+static void duplicates(std::mt19937_64& random, size_t n, std::vector<Point>& points) {
+    const int distinct = 16;
+    std::vector<Point> pool(distinct);
+    uniformSquare(random, distinct, pool);
+    for (size_t i = 0; i < n; i++) {
+        points[i] = pool[random() % distinct];
+    }
+}
+
+// Uniform square, handed over already in the order the hull sorts into
+static void presorted(std::mt19937_64& random, size_t n, std::vector<Point>& points) {
+    uniformSquare(random, n, points);
+    std::sort(points.begin(), points.end());
+}
+
+const char* const distributionNames[] = {
+    "square", "disk", "circle", "gaussian", "collinear", "duplicates", "sorted"
+};
+const size_t distributionCount = sizeof(distributionNames) / sizeof(distributionNames[0]);
+
+static const Generator generators[] = {
+    uniformSquare, uniformDisk, onCircle, gaussianClusters, collinear, duplicates, presorted
+};
+
+bool generatePoints(const std::string& distribution, size_t n, uint64_t seed, std::vector<Point>& points) {
+    for (size_t d = 0; d < distributionCount; d++) {
+        if (distribution != distributionNames[d]) continue;
+        std::mt19937_64 random(seed);
+        points.resize(n);
+        generators[d](random, n, points);
+        return true;
+    }
+    return false;
+}
+
+// Point with another coordinate type, for the float and integer variants
+template <typename T>
+struct BasicPoint {
+    T x, y;
+};
+
+// Largest |coordinate| of the integer variant: differences of two coordinates
+// times a third difference stay exact in the int64 cross product up to 2^30
+#define INTEGER_LIMIT 1073741824.0
+
+// Integer coordinates are scaled up so the inputs keep their shape: by this,
+// or by the largest smaller power of ten that keeps them within INTEGER_LIMIT
+#define INTEGER_SCALE 100000.0
+
+// Hull output in a caller-provided buffer of at least n + 1 points, which is
+// all the chain ever holds; no allocation at all
+template <typename P>
+class PointSpan {
+public:
+    void reset(P* buffer) { data = buffer; count = 0; }
+    size_t size() const { return count; }
+    void push_back(const P& point) { data[count++] = point; }
+    void pop_back() { count--; }
+    P& operator[](size_t i) { return data[i]; }
+    const P& operator[](size_t i) const { return data[i]; }
+
+private:
+    P* data = nullptr;
+    size_t count = 0;
+};
+
+// Keeps up to N points inline and moves to the heap beyond that; most hulls never leave it
+template <typename P, size_t N>
+class SmallVector {
+public:
+    SmallVector() : data(inlinePoints) {}
+    SmallVector(const SmallVector&) = delete;
+    SmallVector& operator=(const SmallVector&) = delete;
+
+    size_t size() const { return count; }
+    void push_back(const P& point) {
+        if (count == capacity) grow();
+        data[count++] = point;
+    }
+    void pop_back() { count--; }
+    P& operator[](size_t i) { return data[i]; }
+    const P& operator[](size_t i) const { return data[i]; }
+
+private:
+    void grow() {
+        std::vector<P> bigger(capacity * 2);
+        std::copy(data, data + count, bigger.begin());
+        heap.swap(bigger);
+        data = heap.data();
+        capacity = heap.size();
+    }
+
+    P inlinePoints[N];
+    P* data;
+    size_t count = 0;
+    size_t capacity = N;
+    std::vector<P> heap;
+};
+
+// How each variant gets the container its hull is built in. prepare runs
+// once per row, outside the timing; init runs on a fresh container every run
+template <typename Container>
+struct FreshOutput {
+    typedef Container type;
+    void prepare(size_t) {}
+    void init(type&) {}
+};
+
+template <typename P>
+struct ReservedOutput {
+    typedef std::vector<P> type;
+    size_t capacity = 0;
+    void prepare(size_t n) { capacity = n + 1; }
+    void init(type& hull) { hull.reserve(capacity); }
+};
+
+template <typename P>
+struct SpanOutput {
+    typedef PointSpan<P> type;
+    std::vector<P> buffer;
+    void prepare(size_t n) { buffer.resize(n + 1); }
+    void init(type& hull) { hull.reset(buffer.data()); }
+};
+
+// The input in the variant's point type; Point itself is used as is.
+// nullptr if the coordinates do not fit the integer variant even unscaled
+template <typename P>
+static const std::vector<P>* convertInput(const std::vector<Point>& points, std::vector<P>& converted, double& scale) {
+    typedef decltype(P().x) Coordinate;
+    scale = 1.0;
+    if (std::is_integral<Coordinate>::value) {
+        double bound = 0.0;
+        for (const Point& point : points) bound = std::max(bound, std::max(std::fabs(point.x), std::fabs(point.y)));
+        if (!(bound <= INTEGER_LIMIT)) return nullptr;
+        scale = INTEGER_SCALE;
+        while (scale > 1.0 && bound * scale > INTEGER_LIMIT) scale /= 10;
+    }
+    converted.resize(points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        converted[i].x = static_cast<Coordinate>(points[i].x * scale);
+        converted[i].y = static_cast<Coordinate>(points[i].y * scale);
+    }
+    return &converted;
+}
+
+static const std::vector<Point>* convertInput(const std::vector<Point>& points, std::vector<Point>&, double& scale) {
+    scale = 1.0;
+    return &points;
+}
+
+// Keeps the counted area computations from being optimized away
+static volatile double areaSink;
+
+// Phases counted apart with --counters
+enum HullPhase {
+    PHASE_SORT,
+    PHASE_LOWER_HULL,
+    PHASE_UPPER_HULL,
+    PHASE_AREA,
+    PHASE_COUNT
+};
+
+static const char* const phaseNames[PHASE_COUNT] = {"sort", "lower_hull", "upper_hull", "area"};
+
+// One instantiation of the hull template
+template <typename P, typename Output, typename Orientation = CrossProductOrientation,
+          typename Sorter = LexicographicSort>
+struct HullVariant {
+    // Times reps runs, each on a fresh copy of the input (the chain sorts in
+    // place, and the copy is made before the clock starts) into a fresh
+    // output container; false if P cannot hold the points
+    static bool time(const std::vector<Point>& points, long reps, std::vector<double>& samples,
+                     size_t& hullSize, double& area) {
+        std::vector<P> converted;
+        double scale;
+        const std::vector<P>* converting = convertInput(points, converted, scale);
+        if (!converting) return false;
+        const std::vector<P>& input = *converting;
+        Output output;
+        output.prepare(input.size());
+
+        std::vector<P> work;
+        for (long r = 0; r < reps; r++) {
+            work.assign(input.begin(), input.end());
+            auto start = std::chrono::steady_clock::now();
+            typename Output::type hull;
+            output.init(hull);
+            monotoneChain<Orientation, Sorter>(work, hull);
+            hullSize = hull.size();
+            area = shoelaceArea(hull) / (scale * scale);
+            auto end = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        return true;
+    }
+
+    // Adds up the hardware counters of each phase over reps more runs; kept
+    // apart from the timed runs so the counter reads do not show in the times
+    static void count(const std::vector<Point>& points, long reps, PerfCounters& counters,
+                      PerfCounts phases[PHASE_COUNT]) {
+        std::vector<P> converted;
+        double scale;
+        const std::vector<P>* converting = convertInput(points, converted, scale);
+        if (!converting || converting->size() <= 1) return;
+        const std::vector<P>& input = *converting;
+        Output output;
+        output.prepare(input.size());
+
+        for (long r = 0; r < reps; r++) {
+            std::vector<P> work(input);
+            typename Output::type hull;
+            output.init(hull);
+
+            counters.start();
+            Sorter()(work.begin(), work.end());
+            counters.stop(phases[PHASE_SORT]);
+            counters.start();
+            chainLowerHull<Orientation>(work, hull);
+            counters.stop(phases[PHASE_LOWER_HULL]);
+            counters.start();
+            chainUpperHull<Orientation>(work, hull);
+            counters.stop(phases[PHASE_UPPER_HULL]);
+            counters.start();
+            areaSink = shoelaceArea(hull);
+            counters.stop(phases[PHASE_AREA]);
+        }
+    }
+};
+
+// A hull variant under test
+struct HullImplementation {
+    const char* name;
+    bool (*time)(const std::vector<Point>& points, long reps, std::vector<double>& samples,
+                 size_t& hullSize, double& area);
+    void (*count)(const std::vector<Point>& points, long reps, PerfCounters& counters,
+                  PerfCounts phases[PHASE_COUNT]);
+};
+
+template <typename Variant>
+static HullImplementation implementation(const char* name) {
+    HullImplementation result = {name, Variant::time, Variant::count};
+    return result;
+}
+
+typedef BasicPoint<float> FloatPoint;
+typedef BasicPoint<int32_t> IntPoint;
+
+// The container / coordinate / predicate / sort matrix; a new variant is a new row
+static const HullImplementation implementations[] = {
+    implementation<HullVariant<Point, FreshOutput<std::vector<Point>>>>("vector"),
+    implementation<HullVariant<Point, FreshOutput<std::deque<Point>>>>("deque"),
+    implementation<HullVariant<Point, ReservedOutput<Point>>>("vector_reserved"),
+    implementation<HullVariant<Point, FreshOutput<SmallVector<Point, 64>>>>("small_vector"),
+    implementation<HullVariant<Point, SpanOutput<Point>>>("span"),
+    implementation<HullVariant<Point, FreshOutput<std::vector<Point>>, CrossProductOrientation,
+                               StableLexicographicSort>>("vector_stable_sort"),
+    implementation<HullVariant<FloatPoint, FreshOutput<std::vector<FloatPoint>>>>("float"),
+    implementation<HullVariant<IntPoint, FreshOutput<std::vector<IntPoint>>, WideOrientation<int64_t>>>("int32"),
+};
+
+// Splits "a,b,c" into its parts
+static std::vector<std::string> splitList(const char* list) {
+    std::vector<std::string> parts;
+    std::string part;
+    for (const char* p = list; ; p++) {
+        if (*p == ',' || *p == '\0') {
+            if (!part.empty()) parts.push_back(part);
+            part.clear();
+            if (*p == '\0') break;
+        } else {
+            part += *p;
+        }
+    }
+    return parts;
+}
+
+// Nearest-rank percentile of sorted samples
+static double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+    return sorted[rank == 0 ? 0 : rank - 1];
+}
+
+// Header columns "<phase>_<counter>" for --counters
+static void printCounterHeader() {
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        for (int c = 0; c < PERF_COUNTER_COUNT; c++) printf(",%s_%s", phaseNames[phase], perfCounterNames[c]);
+    }
+}
+
+// Counts per point of every phase; empty (CSV) or null (JSON) where a counter is unavailable
+static void printCounters(const PerfCounters& counters, const PerfCounts phases[PHASE_COUNT], double points, bool json) {
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        if (json) printf("%s\"%s\": {", phase == 0 ? "" : ", ", phaseNames[phase]);
+        for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+            bool known = counters.available(static_cast<PerfCounter>(c)) && points > 0;
+            double perPoint = known ? phases[phase].value[c] / points : 0.0;
+            if (json) {
+                printf("%s\"%s\": ", c == 0 ? "" : ", ", perfCounterNames[c]);
+                if (known) printf("%.4f", perPoint); else printf("null");
+            } else {
+                printf(",");
+                if (known) printf("%.4f", perPoint);
+            }
+        }
+        if (json) printf("}");
+    }
+}
+
+int runBenchmarkSuite(int argc, char* argv[]) {
+    std::vector<std::string> distributions(distributionNames, distributionNames + distributionCount);
+    std::vector<size_t> sizes = {10, 100, 1000, 10000, 100000, 1000000, 10000000};
+    long fixedReps = 0;
+    uint64_t seed = 1;
+    bool json = false;
+    bool countPhases = false;
+
+    for (int i = 0; i < argc; i++) {
+        const char* option = argv[i];
+        if (strcmp(option, "--counters") == 0) {
+            countPhases = true;
+            continue;
+        }
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            std::cerr << "Missing value for " << option << std::endl;
+            return 1;
+        }
+        i++;
+        if (strcmp(option, "--dist") == 0) {
+            distributions = splitList(value);
+        } else if (strcmp(option, "--sizes") == 0) {
+            sizes.clear();
+            // strtod, so that 1e8 is accepted too
+            for (const std::string& size : splitList(value)) sizes.push_back(static_cast<size_t>(strtod(size.c_str(), nullptr)));
+        } else if (strcmp(option, "--reps") == 0) {
+            fixedReps = atol(value);
+        } else if (strcmp(option, "--seed") == 0) {
+            seed = strtoull(value, nullptr, 10);
+        } else if (strcmp(option, "--format") == 0) {
+            json = strcmp(value, "json") == 0;
+        } else {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+
+    PerfCounters counters;
+    if (countPhases && !counters.open()) {
+        std::cerr << "No hardware counters available (no PMU, or perf_event_paranoid above 2); "
+                     "counter columns stay empty" << std::endl;
+    }
+
+    if (json) {
+        printf("[\n");
+    } else {
+        printf("implementation,distribution,n,seed,reps,hull_size,area,ns_per_point,min_ms,p50_ms,p90_ms,p99_ms,max_ms");
+        if (countPhases) printCounterHeader();
+        printf("\n");
+    }
+
+    bool first = true;
+    std::vector<Point> points;
+    std::vector<double> samples;
+    for (const std::string& distribution : distributions) {
+        for (size_t n : sizes) {
+            if (!generatePoints(distribution, n, seed, points)) {
+                std::cerr << "Unknown distribution " << distribution << std::endl;
+                return 1;
+            }
+            // About 20M points' worth of work per row, within 3..1000 runs
+            long reps = fixedReps > 0 ? fixedReps
+                      : std::max(3L, std::min(1000L, static_cast<long>(20000000 / std::max<size_t>(n, 1))));
+
+            for (const HullImplementation& implementation : implementations) {
+                size_t hullSize = 0;
+                double area = 0.0;
+                samples.clear();
+                if (!implementation.time(points, reps, samples, hullSize, area)) {
+                    std::cerr << "Skipping " << implementation.name << " on " << distribution
+                              << ": its coordinates do not fit" << std::endl;
+                    continue;
+                }
+                std::sort(samples.begin(), samples.end());
+                double p50 = percentile(samples, 50);
+                double nsPerPoint = n > 0 ? p50 * 1e6 / n : 0.0;
+
+                PerfCounts phases[PHASE_COUNT];
+                if (countPhases) implementation.count(points, reps, counters, phases);
+
+                if (json) {
+                    printf("%s  {\"implementation\": \"%s\", \"distribution\": \"%s\", \"n\": %zu, \"seed\": %llu, "
+                           "\"reps\": %ld, \"hull_size\": %zu, \"area\": %.1f, \"ns_per_point\": %.2f, "
+                           "\"min_ms\": %.4f, \"p50_ms\": %.4f, \"p90_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f",
+                           first ? "" : ",\n", implementation.name, distribution.c_str(), n,
+                           static_cast<unsigned long long>(seed), reps, hullSize, area, nsPerPoint,
+                           samples.front(), p50, percentile(samples, 90), percentile(samples, 99), samples.back());
+                    if (countPhases) {
+                        printf(", \"counters_per_point\": {");
+                        printCounters(counters, phases, static_cast<double>(n) * reps, true);
+                        printf("}");
+                    }
+                    printf("}");
+                } else {
+                    printf("%s,%s,%zu,%llu,%ld,%zu,%.1f,%.2f,%.4f,%.4f,%.4f,%.4f,%.4f",
+                           implementation.name, distribution.c_str(), n, static_cast<unsigned long long>(seed),
+                           reps, hullSize, area, nsPerPoint, samples.front(), p50,
+                           percentile(samples, 90), percentile(samples, 99), samples.back());
+                    if (countPhases) printCounters(counters, phases, static_cast<double>(n) * reps, false);
+                    printf("\n");
+                }
+                fflush(stdout);
+                first = false;
+            }
+        }
+    }
+    if (json) printf("\n]\n");
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef BENCHMARK_SUITE_HPP
+#define BENCHMARK_SUITE_HPP
+
+#include "performance_test.hpp"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// Benchmark suite behind "performance_test --suite".
+// Every variant of the hull template (output container, coordinate type,
+// orientation predicate, sort) is timed on seeded synthetic inputs of each
+// distribution and size; one row per (variant, distribution, size) with the
+// hull size, ns per point and percentile timings, as CSV or JSON.
+//
+// Options:
+//   --dist a,b,...     distributions (default: all, see distributionNames)
+//   --sizes n,m,...    point counts (default: 10 to 10M by decades;
+//                      100M works too but needs about 4 GB)
+//   --reps n           timed runs per row (default: scaled to the size, 3 to 1000)
+//   --seed n           generator seed (default 1)
+//   --format csv|json  output format (default csv)
+//   --counters         also count cycles, instructions, L1D and LLC misses and
+//                      branch misses (perf_event_open) of the sort, lower hull,
+//                      upper hull and area phases, over as many extra runs;
+//                      reported per input point as <phase>_<counter> columns
+
+// Names accepted by --dist, in default order
+extern const char* const distributionNames[];
+extern const size_t distributionCount;
+
+// n points of the named distribution, the same for the same seed; false if the name is unknown
+bool generatePoints(const std::string& distribution, size_t n, uint64_t seed, std::vector<Point>& points);
+
+// Runs the suite with the command line options after "--suite"; returns the exit status
+int runBenchmarkSuite(int argc, char* argv[]);
+
+#endif // BENCHMARK_SUITE_HPP
@@ -0,0 +1,121 @@
+#ifndef MONOTONE_CHAIN_HPP
+#define MONOTONE_CHAIN_HPP
+
+#include <algorithm>
+#include <cstddef>
+
+// Andrew's monotone chain as a template, shared by every convexHull.
+// The point type only needs x and y members; the rest is chosen per call:
+//   Orientation  turn(o, a, b): > 0 if o -> a -> b turns left, 0 if collinear
+//   Sorter       sorts a range of points by x, then y
+//   Output       the container the hull is built in; needs size(),
+//                push_back(), pop_back() and operator[] (std::vector,
+//                std::deque, or a caller's fixed buffer behind that interface)
+// The hull comes out counter-clockwise, without collinear points.
+
+// Cross product of OA and OB in the coordinates' own type
+struct CrossProductOrientation {
+    template <typename P>
+    static auto turn(const P& o, const P& a, const P& b) -> decltype((a.x - o.x) * (b.y - o.y)) {
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    }
+};
+
+// Cross product computed in Wide, for integer coordinates whose products overflow
+template <typename Wide>
+struct WideOrientation {
+    template <typename P>
+    static Wide turn(const P& o, const P& a, const P& b) {
+        return (Wide(a.x) - Wide(o.x)) * (Wide(b.y) - Wide(o.y)) -
+               (Wide(a.y) - Wide(o.y)) * (Wide(b.x) - Wide(o.x));
+    }
+};
+
+// By x, then y; the order the chain needs
+struct LexicographicLess {
+    template <typename P>
+    bool operator()(const P& a, const P& b) const {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    }
+};
+
+struct LexicographicSort {
+    template <typename Iterator>
+    void operator()(Iterator begin, Iterator end) const { std::sort(begin, end, LexicographicLess()); }
+};
+
+struct StableLexicographicSort {
+    template <typename Iterator>
+    void operator()(Iterator begin, Iterator end) const { std::stable_sort(begin, end, LexicographicLess()); }
+};
+
+// For input known to be sorted already
+struct NoSort {
+    template <typename Iterator>
+    void operator()(Iterator, Iterator) const {}
+};
+
+// Appends the lower hull of the sorted points, left to right, to the empty hull
+template <typename Orientation, typename Points, typename Output>
+void chainLowerHull(const Points& points, Output& hull) {
+    size_t n = points.size();
+    for (size_t i = 0; i < n; i++) {
+        while (hull.size() >= 2 &&
+               Orientation::turn(hull[hull.size()-2], hull[hull.size()-1], points[i]) <= 0) {
+            hull.pop_back();
+        }
+        hull.push_back(points[i]);
+    }
+}
+
+// Continues the lower hull of at least two sorted points with the upper
+// hull, right to left, and drops the first point it ends on again
+template <typename Orientation, typename Points, typename Output>
+void chainUpperHull(const Points& points, Output& hull) {
+    size_t t = hull.size() + 1;
+    for (size_t i = points.size() - 1; i-- > 0;) {
+        while (hull.size() >= t &&
+               Orientation::turn(hull[hull.size()-2], hull[hull.size()-1], points[i]) <= 0) {
+            hull.pop_back();
+        }
+        hull.push_back(points[i]);
+    }
+    hull.pop_back();
+}
+
+// Appends the hull of the sorted points to the empty hull
+template <typename Orientation, typename Points, typename Output>
+void chainSortedPoints(const Points& points, Output& hull) {
+    size_t n = points.size();
+    if (n <= 1) {
+        for (size_t i = 0; i < n; i++) hull.push_back(points[i]);
+        return;
+    }
+    chainLowerHull<Orientation>(points, hull);
+    chainUpperHull<Orientation>(points, hull);
+}
+
+// Sorts points in place and appends their hull to the empty hull
+template <typename Orientation = CrossProductOrientation, typename Sorter = LexicographicSort,
+          typename Points, typename Output>
+void monotoneChain(Points& points, Output& hull) {
+    Sorter()(points.begin(), points.end());
+    chainSortedPoints<Orientation>(points, hull);
+}
+
+// Shoelace area of a polygon held in any indexable container
+template <typename Polygon>
+double shoelaceArea(const Polygon& vertices) {
+    size_t n = vertices.size();
+    if (n < 3) return 0.0;
+
+    double area = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        size_t j = (i + 1) % n;
+        area += static_cast<double>(vertices[i].x) * vertices[j].y;
+        area -= static_cast<double>(vertices[j].x) * vertices[i].y;
+    }
+    return (area < 0 ? -area : area) / 2.0;
+}
+
+#endif // MONOTONE_CHAIN_HPP
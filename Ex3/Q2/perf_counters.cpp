@@ -0,0 +1,75 @@
+#include "perf_counters.hpp"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+
+const char* const perfCounterNames[PERF_COUNTER_COUNT] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+};
+
+// perf_event_attr type and config of each PerfCounter
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} perfEvents[PERF_COUNTER_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+PerfCounters::PerfCounters() : leader(-1), memberCount(0) {
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) fds[c] = -1;
+}
+
+PerfCounters::~PerfCounters() {
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        if (fds[c] >= 0) close(fds[c]);
+    }
+}
+
+bool PerfCounters::open() {
+    for (int c = 0; c < PERF_COUNTER_COUNT; c++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = perfEvents[c].type;
+        attr.config = perfEvents[c].config;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = leader < 0; // Members follow the leader
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+        if (fd < 0) continue;
+        fds[c] = fd;
+        if (leader < 0) leader = fd;
+        members[memberCount++] = c;
+    }
+    return leader >= 0;
+}
+
+void PerfCounters::start() {
+    if (leader < 0) return;
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void PerfCounters::stop(PerfCounts& total) {
+    if (leader < 0) return;
+    ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    // {nr, time_enabled, time_running, value[nr]}
+    uint64_t data[3 + PERF_COUNTER_COUNT];
+    ssize_t n = read(leader, data, sizeof(data));
+    if (n < static_cast<ssize_t>(3 * sizeof(uint64_t)) || data[0] != static_cast<uint64_t>(memberCount)) return;
+    if (data[2] == 0) return; // Never got onto the PMU
+    double scale = static_cast<double>(data[1]) / data[2];
+    for (int i = 0; i < memberCount; i++) {
+        total.value[members[i]] += data[3 + i] * scale;
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <cstdint>
+
+// Hardware performance counters of this thread, read with perf_event_open.
+// User space only, so it works with the default perf_event_paranoid of 2.
+// Counters the CPU (or a VM without a virtual PMU) does not provide are
+// simply unavailable; the rest are still counted.
+
+enum PerfCounter {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,     // L1 data cache read misses
+    PERF_LLC_MISSES,     // Last level cache misses
+    PERF_BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+};
+
+// Column names, in PerfCounter order
+extern const char* const perfCounterNames[PERF_COUNTER_COUNT];
+
+// Counts added up over any number of start/stop intervals
+struct PerfCounts {
+    double value[PERF_COUNTER_COUNT];
+
+    PerfCounts() { clear(); }
+    void clear() { for (int c = 0; c < PERF_COUNTER_COUNT; c++) value[c] = 0; }
+};
+
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Opens every counter as one group; false if none is available
+    bool open();
+    bool available(PerfCounter counter) const { return fds[counter] >= 0; }
+
+    // Counts between start and stop are added to total, scaled up if the
+    // kernel had to multiplex the group with other events
+    void start();
+    void stop(PerfCounts& total);
+
+private:
+    int leader;
+    int fds[PERF_COUNTER_COUNT];
+    int members[PERF_COUNTER_COUNT]; // PerfCounter of each group member, in read order
+    int memberCount;
+};
+
+#endif // PERF_COUNTERS_HPP
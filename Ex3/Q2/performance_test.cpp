@@ -1,9 +1,14 @@
 #include "performance_test.hpp"
+#include "benchmark_suite.hpp"
+#include "monotone_chain.hpp"
 #include <iostream>
 #include <vector>
 #include <deque>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
 #include <iomanip>
 #include <chrono>
 #include <string>
@@ -23,101 +28,141 @@ double crossProduct(const Point& O, const Point& A, const Point& B) {
 
 // Vector-based convex hull implementation
 std::vector<Point> convexHullVector(std::vector<Point> points) {
-    size_t n = points.size();
-    if (n <= 1) return points;
-    
-    std::sort(points.begin(), points.end());
-    
-    // Build lower hull using vector
     std::vector<Point> hull;
-    for (size_t i = 0; i < n; i++) {
-        while (hull.size() >= 2 && 
-               crossProduct(hull[hull.size()-2], hull[hull.size()-1], points[i]) <= 0) {
-            hull.pop_back();
-        }
-        hull.push_back(points[i]);
-    }
-    
-    // Build upper hull
-    size_t t = hull.size() + 1;
-    for (int i = static_cast<int>(n) - 2; i >= 0; i--) {  
-        while (hull.size() >= t && 
-               crossProduct(hull[hull.size()-2], hull[hull.size()-1], points[i]) <= 0) {
-            hull.pop_back();
-        }
-        hull.push_back(points[i]);
-    }
-    
-    hull.pop_back();
+    monotoneChain(points, hull);
     return hull;
 }
 
 // Deque-based convex hull implementation
 std::deque<Point> convexHullDeque(std::vector<Point> points) {
-    size_t n = points.size();
-    if (n <= 1) {
-        std::deque<Point> result;
-        for (const auto& p : points) result.push_back(p);
-        return result;
-    }
-    
-    std::sort(points.begin(), points.end());
-    
-    // Build lower hull using deque
     std::deque<Point> hull;
-    for (size_t i = 0; i < n; i++) {
-        while (hull.size() >= 2 && 
-               crossProduct(hull[hull.size()-2], hull[hull.size()-1], points[i]) <= 0) {
-            hull.pop_back();
-        }
-        hull.push_back(points[i]);
-    }
-    
-    // Build upper hull
-    size_t t = hull.size() + 1;
-    for (int i = static_cast<int>(n) - 2; i >= 0; i--) { 
-        while (hull.size() >= t && 
-               crossProduct(hull[hull.size()-2], hull[hull.size()-1], points[i]) <= 0) {
-            hull.pop_back();
-        }
-        hull.push_back(points[i]);
-    }
-    
-    hull.pop_back();
+    monotoneChain(points, hull);
     return hull;
 }
 
 // Calculate area using vector
 double polygonAreaVector(const std::vector<Point>& vertices) {
-    int n = vertices.size();
-    if (n < 3) return 0.0;
-    
-    double area = 0.0;
-    for (int i = 0; i < n; i++) {
-        int j = (i + 1) % n;
-        area += vertices[i].x * vertices[j].y;
-        area -= vertices[j].x * vertices[i].y;
-    }
-    
-    return std::abs(area) / 2.0;
+    return shoelaceArea(vertices);
 }
 
 // Calculate area using deque
 double polygonAreaDeque(const std::deque<Point>& vertices) {
-    int n = vertices.size();
-    if (n < 3) return 0.0;
-    
-    double area = 0.0;
-    for (int i = 0; i < n; i++) {
-        int j = (i + 1) % n;
-        area += vertices[i].x * vertices[j].y;
-        area -= vertices[j].x * vertices[i].y;
+    return shoelaceArea(vertices);
+}
+
+// Whitespace as accepted around numbers (C locale, no function call)
+static inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// '0'..'9' with a single comparison
+static inline bool isDigit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// Powers of ten that are exact doubles
+static const double exactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Parse a decimal number (sign, fraction, exponent) starting at p, skipping
+// leading whitespace. Returns the position after it, or nullptr if there is
+// no finite number there. Never allocates and ignores the locale.
+const char* parseDouble(const char* p, const char* end, double& value) {
+    while (p < end && isSpace(*p)) p++;
+    const char* start = p;
+
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = (*p == '-');
+        p++;
     }
-    
-    return std::abs(area) / 2.0;
+
+    // Accumulate every digit; only trusted below when there are at most 19
+    uint64_t mantissa = 0;
+    const char* digitsStart = p;
+    while (p < end && isDigit(*p)) {
+        mantissa = mantissa * 10 + (*p - '0');
+        p++;
+    }
+    int digits = static_cast<int>(p - digitsStart);
+    int exponent = 0;  // Power of ten applied to mantissa
+    if (p < end && *p == '.') {
+        const char* fraction = ++p;
+        while (p < end && isDigit(*p)) {
+            mantissa = mantissa * 10 + (*p - '0');
+            p++;
+        }
+        exponent = -static_cast<int>(p - fraction);
+        digits -= exponent;
+    }
+    if (digits == 0) return nullptr;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool expNegative = false;
+        if (q < end && (*q == '+' || *q == '-')) {
+            expNegative = (*q == '-');
+            q++;
+        }
+        if (q < end && isDigit(*q)) {
+            int e = 0;
+            for (; q < end && isDigit(*q); q++) {
+                if (e < 100000) e = e * 10 + (*q - '0');
+            }
+            exponent += expNegative ? -e : e;
+            p = q;
+        }
+    }
+
+    // Exact when both the mantissa and the power of ten are exact doubles
+    if (digits <= 19 && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        double v = static_cast<double>(mantissa);
+        v = exponent < 0 ? v / exactPowersOfTen[-exponent] : v * exactPowersOfTen[exponent];
+        value = negative ? -v : v;
+        return p;
+    }
+
+    // Rare long or extreme inputs: let strtod round them correctly
+    char text[128];
+    size_t len = p - start;
+    if (len >= sizeof(text)) return nullptr;
+    memcpy(text, start, len);
+    text[len] = '\0';
+    value = strtod(text, nullptr);
+    if (!std::isfinite(value)) return nullptr;
+    return p;
+}
+
+// Parse point "x,y" from [begin, end); whitespace around the numbers is allowed
+bool parsePoint(const char* begin, const char* end, Point& point) {
+    double x, y;
+    const char* p = parseDouble(begin, end, x);
+    if (!p) return false;
+    while (p < end && isSpace(*p)) p++;
+    if (p == end || *p != ',') return false;
+
+    p = parseDouble(p + 1, end, y);
+    if (!p) return false;
+    while (p < end && isSpace(*p)) p++;
+    if (p != end) return false;
+
+    point = Point(x, y);
+    return true;
+}
+
+// Parse point from string "x,y"
+bool parsePoint(const std::string& pointStr, Point& point) {
+    return parsePoint(pointStr.data(), pointStr.data() + pointStr.size(), point);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // "performance_test --suite [options]" runs the benchmark suite instead (see benchmark_suite.hpp)
+    if (argc > 1 && strcmp(argv[1], "--suite") == 0) {
+        return runBenchmarkSuite(argc - 2, argv + 2);
+    }
+
     int n;
     std::cout << "Enter number of points: ";
     std::cin >> n;
@@ -125,15 +170,11 @@ int main() {
     std::vector<Point> points(n);
     
     std::cout << "Enter points (format: x,y):" << std::endl;
+    std::string line;
     for (int i = 0; i < n; i++) {
-        std::string line;
         std::cin >> line;
-        
-        size_t commaPos = line.find(',');
-        if (commaPos != std::string::npos) {
-            double x = std::stod(line.substr(0, commaPos));
-            double y = std::stod(line.substr(commaPos + 1));
-            points[i] = Point(x, y);
+        if (!parsePoint(line, points[i])) {
+            std::cerr << "Invalid point: " << line << std::endl;
         }
     }
     
@@ -2,6 +2,7 @@
 #define PERFORMANCE_TEST_HPP
 
 #include <vector>
+#include <string>
 #include <deque>
 
 struct Point {
@@ -24,4 +25,12 @@ std::deque<Point> convexHullDeque(std::vector<Point> points);
 
 double polygonAreaDeque(const std::deque<Point>& vertices);
 
+// Parses a number at p (after optional whitespace); returns the position after it or nullptr
+const char* parseDouble(const char* p, const char* end, double& value);
+
+// Parses "x,y" into point without allocating; false if malformed
+bool parsePoint(const char* begin, const char* end, Point& point);
+
+bool parsePoint(const std::string& pointStr, Point& point);
+
 #endif // PERFORMANCE_TEST_HPP
\ No newline at end of file
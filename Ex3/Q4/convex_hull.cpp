@@ -1,21 +1,29 @@
 #include "convex_hull.hpp"
+#include "monotone_chain.hpp"
+#include "logger.hpp"
 #include <iostream>
 #include <vector>
 #include <string>
-#include <sstream>
 #include <algorithm>
+#include <new>
 #include <cmath>
-#include <iomanip>
+#include <cstdlib>
+#include <cstdint>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
+#include <cstdio>
+#include <cerrno>
 #include <fcntl.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 #define PORT 9034
 #define MAXCLIENTS 10
-#define BUFSIZE 1024
+#define BUFSIZE 65536
 
 // Global graph data structure shared by all clients
 std::vector<Point> globalGraph;
@@ -39,35 +47,8 @@ double crossProduct(const Point& O, const Point& A, const Point& B) {
 
 // Calculate convex hull using Andrew's monotone chain algorithm
 std::vector<Point> convexHull(std::vector<Point> points) {
-    int n = points.size();
-    if (n <= 1) return points;
-    
-    // Sort points lexicographically
-    std::sort(points.begin(), points.end());
-    
-    // Build lower hull
     std::vector<Point> hull;
-    for (int i = 0; i < n; i++) {
-        while (hull.size() >= 2 && 
-               crossProduct(hull[hull.size()-2], hull[hull.size()-1], points[i]) <= 0) {
-            hull.pop_back();
-        }
-        hull.push_back(points[i]);
-    }
-    
-    // Build upper hull
-    size_t t = hull.size() + 1;
-    for (int i = n - 2; i >= 0; i--) {
-        while (hull.size() >= t && 
-               crossProduct(hull[hull.size()-2], hull[hull.size()-1], points[i]) <= 0) {
-            hull.pop_back();
-        }
-        hull.push_back(points[i]);
-    }
-    
-    // Remove the last point because it's the same as the first
-    hull.pop_back();
-    
+    monotoneChain(points, hull);
     return hull;
 }
 
@@ -86,99 +67,574 @@ double polygonArea(const std::vector<Point>& vertices) {
     return std::abs(area) / 2.0;
 }
 
+// Whitespace as accepted around numbers (C locale, no function call)
+static inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// '0'..'9' with a single comparison
+static inline bool isDigit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// Powers of ten that are exact doubles
+static const double exactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Parse a decimal number (sign, fraction, exponent) starting at p, skipping
+// leading whitespace. Returns the position after it, or nullptr if there is
+// no finite number there. Never allocates and ignores the locale.
+const char* parseDouble(const char* p, const char* end, double& value) {
+    while (p < end && isSpace(*p)) p++;
+    const char* start = p;
+
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    // Accumulate every digit; only trusted below when there are at most 19
+    uint64_t mantissa = 0;
+    const char* digitsStart = p;
+    while (p < end && isDigit(*p)) {
+        mantissa = mantissa * 10 + (*p - '0');
+        p++;
+    }
+    int digits = static_cast<int>(p - digitsStart);
+    int exponent = 0;  // Power of ten applied to mantissa
+    if (p < end && *p == '.') {
+        const char* fraction = ++p;
+        while (p < end && isDigit(*p)) {
+            mantissa = mantissa * 10 + (*p - '0');
+            p++;
+        }
+        exponent = -static_cast<int>(p - fraction);
+        digits -= exponent;
+    }
+    if (digits == 0) return nullptr;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool expNegative = false;
+        if (q < end && (*q == '+' || *q == '-')) {
+            expNegative = (*q == '-');
+            q++;
+        }
+        if (q < end && isDigit(*q)) {
+            int e = 0;
+            for (; q < end && isDigit(*q); q++) {
+                if (e < 100000) e = e * 10 + (*q - '0');
+            }
+            exponent += expNegative ? -e : e;
+            p = q;
+        }
+    }
+
+    // Exact when both the mantissa and the power of ten are exact doubles
+    if (digits <= 19 && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        double v = static_cast<double>(mantissa);
+        v = exponent < 0 ? v / exactPowersOfTen[-exponent] : v * exactPowersOfTen[exponent];
+        value = negative ? -v : v;
+        return p;
+    }
+
+    // Rare long or extreme inputs: let strtod round them correctly
+    char text[128];
+    size_t len = p - start;
+    if (len >= sizeof(text)) return nullptr;
+    memcpy(text, start, len);
+    text[len] = '\0';
+    value = strtod(text, nullptr);
+    if (!std::isfinite(value)) return nullptr;
+    return p;
+}
+
+// Parse point "x,y" from [begin, end); whitespace around the numbers is allowed
+bool parsePoint(const char* begin, const char* end, Point& point) {
+    double x, y;
+    const char* p = parseDouble(begin, end, x);
+    if (!p) return false;
+    while (p < end && isSpace(*p)) p++;
+    if (p == end || *p != ',') return false;
+
+    p = parseDouble(p + 1, end, y);
+    if (!p) return false;
+    while (p < end && isSpace(*p)) p++;
+    if (p != end) return false;
+
+    point = Point(x, y);
+    return true;
+}
+
 // Parse point from string "x,y"
-Point parsePoint(const std::string& pointStr) {
-    size_t commaPos = pointStr.find(',');
-    if (commaPos != std::string::npos) {
-        double x = std::stod(pointStr.substr(0, commaPos));
-        double y = std::stod(pointStr.substr(commaPos + 1));
-        return Point(x, y);
+bool parsePoint(const std::string& pointStr, Point& point) {
+    return parsePoint(pointStr.data(), pointStr.data() + pointStr.size(), point);
+}
+
+// Bitmask of the whitespace bytes among the 64 bytes at p (bit i = p[i]);
+// a window cut short by end only reports the bytes before end
+static uint64_t whitespaceBits(const char* p, const char* end) {
+    if (end - p < 64) {
+        uint64_t bits = 0;
+        for (int i = 0; p + i < end; i++) {
+            if (isSpace(p[i])) bits |= 1ULL << i;
+        }
+        return bits;
+    }
+#if defined(__AVX2__)
+    // ' ' or '\t'..'\r'; bytes >= 0x80 compare as negative and never match
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i low = _mm256_set1_epi8('\t' - 1);
+    const __m256i high = _mm256_set1_epi8('\r' + 1);
+    uint64_t bits = 0;
+    for (int i = 0; i < 64; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+            _mm256_and_si256(_mm256_cmpgt_epi8(v, low), _mm256_cmpgt_epi8(high, v)));
+        bits |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(ws))) << i;
+    }
+    return bits;
+#elif defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i low = _mm_set1_epi8('\t' - 1);
+    const __m128i high = _mm_set1_epi8('\r' + 1);
+    uint64_t bits = 0;
+    for (int i = 0; i < 64; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+            _mm_and_si128(_mm_cmpgt_epi8(v, low), _mm_cmplt_epi8(v, high)));
+        bits |= static_cast<uint64_t>(_mm_movemask_epi8(ws)) << i;
+    }
+    return bits;
+#else
+    uint64_t bits = 0;
+    for (int i = 0; i < 64; i++) {
+        if (isSpace(p[i])) bits |= 1ULL << i;
     }
-    return Point(0, 0);
+    return bits;
+#endif
+}
+
+size_t scanPoints(const char* begin, const char* end, long& pending,
+                  std::vector<Point>& points, bool& invalid) {
+    const char* p = begin;      // Start of the current token (or whitespace before it)
+    bool prevSpace = true;      // Whether the byte before the window is whitespace
+
+    for (const char* base = begin; pending > 0 && base < end; base += 64) {
+        uint64_t space = whitespaceBits(base, end);
+        // A token ends at each whitespace byte that follows a non-whitespace one
+        uint64_t ends = space & ~((space << 1) | (prevSpace ? 1 : 0));
+        prevSpace = (space >> 63) != 0;
+
+        while (ends && pending > 0) {
+            const char* stop = base + __builtin_ctzll(ends);
+            ends &= ends - 1;
+
+            // parsePoint skips the whitespace in front of the token itself
+            Point point;
+            if (parsePoint(p, stop, point)) {
+                points.push_back(point);
+            } else {
+                invalid = true;
+            }
+            pending--;
+            p = stop;
+        }
+    }
+
+    // A token without a whitespace after it may continue in the next read
+    return p - begin;
+}
+
+// "ip:port" of a client, formatted once per connection for log lines
+void formatPeer(const struct sockaddr_in& addr, char* text, size_t size) {
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+    snprintf(text, size, "%s:%u", ip, static_cast<unsigned>(ntohs(addr.sin_port)));
 }
 
 // Send message to a specific client
 void sendToClient(int clientSocket, const std::string& message) {
     std::string msg = message + "\n";
-    send(clientSocket, msg.c_str(), msg.length(), 0);
+    send(clientSocket, msg.c_str(), msg.length(), MSG_NOSIGNAL);
 }
 
-// Process command from a client and return response
-std::string processCommand(const std::string& command) {
-    std::istringstream iss(command);
-    std::string cmd;
-    iss >> cmd;
-    
-    if (cmd == "Newgraph") {
-        int n;
-        iss >> n;
-        
-        // Clear the global graph and prepare for new points
-        globalGraph.clear();
-        globalGraph.reserve(n);
-        
-        counter = n; // Set counter for expected points
-        if (n <= 0) {
-            return "Invalid number of points. Please specify a positive integer.";
-        }
-        return "Ready for " + std::to_string(n) + " points. Send points one by one.";
-        
-    } else if (cmd == "CH") {
-        // Calculate and return convex hull area
-        std::vector<Point> hull = convexHull(globalGraph);
-        double area = polygonArea(hull);
-        
-        std::ostringstream oss;
-        oss << std::fixed << std::setprecision(1) << area;
-        return "Convex Hull Area: " + oss.str();
-        
-    } else if (cmd == "Newpoint") {
-        // Add a new point to existing graph
-        std::string pointStr;
-        iss >> pointStr;
-        Point newPoint = parsePoint(pointStr);
+// Send everything buffered in output with as few send calls as the socket allows
+void flushOutput(int clientSocket, std::string& output) {
+    size_t sent = 0;
+    while (sent < output.size()) {
+        ssize_t n = send(clientSocket, output.data() + sent, output.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += n;
+    }
+    output.clear(); // Keeps the capacity for the next batch
+}
+
+void appendInt(std::string& out, long long value) {
+    char text[24];
+    char* end = text + sizeof(text);
+    char* p = end;
+    unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : value;
+    do {
+        *--p = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) *--p = '-';
+    out.append(p, end - p);
+}
+
+static const double decimalScales[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+
+void appendFixed(std::string& out, double value, int decimals) {
+    double scaled = std::fabs(value) * (decimals >= 0 && decimals <= 6 ? decimalScales[decimals] : 0);
+    double whole = std::floor(scaled);
+    double fraction = scaled - whole;
+
+    // Large values, NaN/inf and near-ties need printf's exact rounding
+    if (decimals < 0 || decimals > 6 || !(scaled < 1e12) || std::fabs(fraction - 0.5) < 1e-3) {
+        char text[512];
+        int n = snprintf(text, sizeof(text), "%.*f", decimals, value);
+        if (n > 0) out.append(text, std::min(static_cast<size_t>(n), sizeof(text) - 1));
+        return;
+    }
+
+    uint64_t units = static_cast<uint64_t>(whole) + (fraction > 0.5 ? 1 : 0);
+    char text[32];
+    char* end = text + sizeof(text);
+    char* p = end;
+    for (int i = 0; i < decimals; i++) {
+        *--p = static_cast<char>('0' + units % 10);
+        units /= 10;
+    }
+    if (decimals > 0) *--p = '.';
+    do {
+        *--p = static_cast<char>('0' + units % 10);
+        units /= 10;
+    } while (units);
+    if (std::signbit(value)) *--p = '-';
+    out.append(p, end - p);
+}
+
+void appendPoint(std::string& out, const Point& point) {
+    out += '(';
+    appendFixed(out, point.x, 6);
+    out += ',';
+    appendFixed(out, point.y, 6);
+    out += ')';
+}
+
+// Append received bytes, dropping what earlier reads already consumed
+void appendInput(ClientInput& input, const char* data, size_t len) {
+    if (input.pos > 0) {
+        input.buffer.erase(0, input.pos);
+        input.pos = 0;
+    }
+    input.buffer.append(data, len);
+}
+
+// Take the next newline-terminated command off the input
+bool nextLine(ClientInput& input, std::string& line) {
+    size_t newline = input.buffer.find('\n', input.pos);
+    if (newline == std::string::npos) return false;
+
+    line.assign(input.buffer, input.pos, newline - input.pos);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    input.pos = newline + 1;
+    return true;
+}
+
+// Whether the unconsumed input is longer than any command line or payload point
+// may be; only meaningful once every complete line has been taken off
+bool lineTooLong(const ClientInput& input) {
+    return input.buffer.size() - input.pos > MAX_LINE_LENGTH;
+}
+
+// Parse "Loadpoints <n>"; the n points follow as one payload
+void startBulkLoad(ClientInput& input, const char* args, const char* end, std::string& out) {
+    long n;
+    if (!parseInteger(nextToken(args, end), n) || n <= 0) {
+        out += "Invalid number of points. Please specify a positive integer.";
+        return;
+    }
+    if (n > MAX_LOAD_POINTS) {
+        out += "Too many points for one Loadpoints (at most ";
+        appendInt(out, MAX_LOAD_POINTS);
+        out += ").";
+        return;
+    }
+
+    input.pendingPoints = n;
+    input.bulkInvalid = false;
+    input.bulkPoints.clear();
+    // n is only the client's word: larger uploads grow as their points arrive
+    input.bulkPoints.reserve(std::min(n, static_cast<long>(LOAD_RESERVE_POINTS)));
+}
+
+// Parse the payload points received so far ("x,y" separated by whitespace)
+bool consumeBulkPoints(ClientInput& input) {
+    const char* data = input.buffer.data();
+    input.pos += scanPoints(data + input.pos, data + input.buffer.size(),
+                            input.pendingPoints, input.bulkPoints, input.bulkInvalid);
+    return input.pendingPoints == 0;
+}
+
+void finishBulkLoad(ClientInput& input, std::string& out) {
+    if (input.bulkInvalid) {
+        std::vector<Point>().swap(input.bulkPoints);
+        out += "Invalid point format in Loadpoints payload. Graph unchanged.\n";
+        return;
+    }
+
+    size_t loaded = input.bulkPoints.size();
+    globalGraph.swap(input.bulkPoints);
+    counter = 0;
+
+    // Release the previous graph now held by the input
+    std::vector<Point>().swap(input.bulkPoints);
+    out += "Graph loaded with ";
+    appendInt(out, loaded);
+    out += " points.\n";
+}
+
+// Next whitespace-separated token at or after p; empty at the end of the line
+Token nextToken(const char*& p, const char* end) {
+    while (p < end && isSpace(*p)) p++;
+    Token token;
+    token.begin = p;
+    while (p < end && !isSpace(*p)) p++;
+    token.end = p;
+    return token;
+}
+
+// Parse a whole token as an integer of at most 9 digits
+bool parseInteger(const Token& token, long& value) {
+    const char* p = token.begin;
+    bool negative = p < token.end && *p == '-';
+    if (negative || (p < token.end && *p == '+')) p++;
+    if (p == token.end || token.end - p > 9) return false;
+
+    long v = 0;
+    for (; p < token.end; p++) {
+        if (!isDigit(*p)) return false;
+        v = v * 10 + (*p - '0');
+    }
+    value = negative ? -v : v;
+    return true;
+}
+
+// Command handlers; [args, end) is the rest of the line after the command word.
+// Each appends its reply, without the newline, to out
+
+static void cmdNewgraph(ClientInput&, const char* args, const char* end, std::string& out) {
+    long n;
+    if (!parseInteger(nextToken(args, end), n)) n = 0;
+
+    // Clear the graph and prepare for new points
+    globalGraph.clear();
+    if (n > 0) globalGraph.reserve(n);
+
+    counter = n; // Set counter for expected points
+    if (n <= 0) {
+        out += "Invalid number of points. Please specify a positive integer.";
+        return;
+    }
+    out += "Ready for ";
+    appendInt(out, n);
+    out += " points. Send points one by one.";
+}
+
+static void cmdCH(ClientInput&, const char*, const char*, std::string& out) {
+    // Calculate and return convex hull area
+    std::vector<Point> hull = convexHull(globalGraph);
+    out += "Convex Hull Area: ";
+    appendFixed(out, polygonArea(hull), 1);
+}
+
+static void cmdNewpoint(ClientInput&, const char* args, const char* end, std::string& out) {
+    // Add a new point to existing graph
+    Token pointArg = nextToken(args, end);
+    Point newPoint;
+    if (!parsePoint(pointArg.begin, pointArg.end, newPoint)) {
+        out += "Invalid point format. Please use 'Newpoint <x,y>'.";
+        return;
+    }
+
+    globalGraph.push_back(newPoint);
+    out += "New point added: ";
+    appendPoint(out, newPoint);
+}
+
+static void cmdRemovepoint(ClientInput&, const char* args, const char* end, std::string& out) {
+    // Remove a point from the graph
+    Token pointArg = nextToken(args, end);
+    Point pointToRemove;
+    if (!parsePoint(pointArg.begin, pointArg.end, pointToRemove)) {
+        out += "Invalid point format. Please use 'Removepoint <x,y>'.";
+        return;
+    }
+
+    // Find and remove the point
+    auto it = std::find(globalGraph.begin(), globalGraph.end(), pointToRemove);
+    if (it != globalGraph.end()) {
+        globalGraph.erase(it);
+        out += "Point removed: ";
+    } else {
+        out += "Point not found: ";
+    }
+    appendPoint(out, pointToRemove);
+}
+
+static void cmdStatus(ClientInput&, const char*, const char*, std::string& out) {
+    // Return current graph status
+    out += "Current graph has ";
+    appendInt(out, globalGraph.size());
+    out += " points";
+}
+
+// The payload that follows is read by the input loop; nothing to reply until it is in
+static void cmdLoadpoints(ClientInput& input, const char* args, const char* end, std::string& out) {
+    startBulkLoad(input, args, end, out);
+}
+
+#define COMMAND(name, handler) { name, sizeof(name) - 1, handler }
+
+// Every text command; adding one is a new row here
+static constexpr CommandEntry commandTable[] = {
+    COMMAND("Newgraph", cmdNewgraph),
+    COMMAND("CH", cmdCH),
+    COMMAND("Newpoint", cmdNewpoint),
+    COMMAND("Removepoint", cmdRemovepoint),
+    COMMAND("Status", cmdStatus),
+    COMMAND("Loadpoints", cmdLoadpoints)
+};
+
+static constexpr size_t commandCount = sizeof(commandTable) / sizeof(commandTable[0]);
+
+#define COMMAND_SLOTS 64
+
+// Dispatch slot of a command word, from its length and first and last characters
+static constexpr unsigned commandSlot(const char* word, size_t length) {
+    return (length * 5 + static_cast<unsigned char>(word[0]) +
+            static_cast<unsigned char>(word[length - 1]) * 2) % COMMAND_SLOTS;
+}
+
+// Index of the command in slot, or -1
+static constexpr int commandInSlot(unsigned slot, size_t i = 0) {
+    return i == commandCount ? -1
+         : commandSlot(commandTable[i].name, commandTable[i].length) == slot ? static_cast<int>(i)
+         : commandInSlot(slot, i + 1);
+}
+
+// True if every command has a slot of its own
+static constexpr bool slotsDistinct(size_t i = 0) {
+    return i == commandCount ||
+           (commandInSlot(commandSlot(commandTable[i].name, commandTable[i].length)) == static_cast<int>(i) &&
+            slotsDistinct(i + 1));
+}
+
+static_assert(slotsDistinct(), "Two commands share a dispatch slot; change commandSlot");
+
+#define SLOT_ROW(n) commandInSlot(n), commandInSlot(n + 1), commandInSlot(n + 2), commandInSlot(n + 3), \
+                    commandInSlot(n + 4), commandInSlot(n + 5), commandInSlot(n + 6), commandInSlot(n + 7)
+
+// Slot -> commandTable index, computed by the compiler
+static constexpr signed char commandSlots[COMMAND_SLOTS] = {
+    SLOT_ROW(0), SLOT_ROW(8), SLOT_ROW(16), SLOT_ROW(24),
+    SLOT_ROW(32), SLOT_ROW(40), SLOT_ROW(48), SLOT_ROW(56)
+};
+
+const CommandEntry* findCommand(const char* word, size_t length) {
+    if (length == 0) return nullptr;
+    int index = commandSlots[commandSlot(word, length)];
+    if (index < 0) return nullptr;
+
+    const CommandEntry& entry = commandTable[index];
+    if (entry.length != length || memcmp(entry.name, word, length) != 0) return nullptr;
+    return &entry;
+}
+
+// Process command from a client and append the response line to out
+void processCommand(ClientInput& input, const std::string& command, std::string& out) {
+    // While a graph is being filled nearly every line is a point; skip the tokenizer for those
+    Point newPoint;
+    if (counter > 0 && parsePoint(command, newPoint)) {
         globalGraph.push_back(newPoint);
-        
-        return "New point added: (" + std::to_string(newPoint.x) + "," + std::to_string(newPoint.y) + ")";
-        
-    } else if (cmd == "Removepoint") {
-        // Remove a point from the graph
-        std::string pointStr;
-        iss >> pointStr;
-        Point pointToRemove = parsePoint(pointStr);
-        
-        // Find and remove the point
-        auto it = std::find(globalGraph.begin(), globalGraph.end(), pointToRemove);
-        if (it != globalGraph.end()) {
-            globalGraph.erase(it);
-            return "Point removed: (" + std::to_string(pointToRemove.x) + "," + std::to_string(pointToRemove.y) + ")";
-        } else {
-            return "Point not found: (" + std::to_string(pointToRemove.x) + "," + std::to_string(pointToRemove.y) + ")";
-        }
-        
-    } else if (cmd == "Status") {
-        // Return current graph status
-        return "Current graph has " + std::to_string(globalGraph.size()) + " points";
-        
+        counter--;
+        out += "Point added: ";
+        appendPoint(out, newPoint);
+        out += '\n';
+        return;
+    }
+
+    const char* p = command.data();
+    const char* end = p + command.size();
+    Token cmd = nextToken(p, end);
+    const CommandEntry* entry = findCommand(cmd.begin, cmd.end - cmd.begin);
+    if (entry) {
+        size_t mark = out.size();
+        entry->handler(input, p, end, out);
+        if (out.size() != mark) out += '\n'; // Loadpoints replies once its payload is in
+        return;
+    }
+
+    if (counter > 0){
+        out += "Unknown command or invalid point format. Please use one of the following commands:\n"
+            "Newgraph <n>, <x,y>, Loadpoints <n>, CH, Newpoint <x,y>, Removepoint <x,y>, Status\n";
     } else {
-        if (counter > 0){        
-            try {
-                Point newPoint = parsePoint(command);
-                globalGraph.push_back(newPoint);
-                counter--;
-                return "Point added: (" + std::to_string(newPoint.x) + "," + std::to_string(newPoint.y) + ")";
-            } catch (...) {
-                return "Unknown command or invalid point format. Please use one of the following commands:\n"
-                    "Newgraph <n>, <x,y>, CH, Newpoint <x,y>, Removepoint <x,y>, Status";
+        out += "The graph is full. Please start a new graph with 'Newgraph <n>' command or add new points with 'Newpoint <x,y>'.\n";
+    }
+}
+
+// Append a read's bytes and run every complete command received so far, leaving
+// the replies in input.output. False if the connection has to be dropped
+bool serveInput(ClientInput& input, const char* data, size_t len, const char* peer) {
+    std::string command;
+    std::string& out = input.output;
+    try {
+        appendInput(input, data, len);
+        while (true) {
+            size_t mark = out.size();
+            if (input.pendingPoints > 0) {
+                // Loadpoints payload: a single reply once the last point is in
+                if (!consumeBulkPoints(input)) break;
+                finishBulkLoad(input, out);
+            } else {
+                if (!nextLine(input, command)) break;
+                if (command.empty()) continue;
+
+                logMessage(LOG_DEBUG, "Received command from %s: %s", peer, command.c_str());
+
+                processCommand(input, command, out);
             }
-        } else {
-            return "The graph is full. Please start a new graph with 'Newgraph <n>' command or add new points with 'Newpoint <x,y>'.";
+            if (out.size() == mark) continue;
+
+            logMessage(LOG_DEBUG, "Sent response to %s: %.*s", peer,
+                       static_cast<int>(out.size() - mark - 1), out.data() + mark);
+        }
+
+        // A client that never ends its line would otherwise grow the buffer without bound
+        if (lineTooLong(input)) {
+            logMessage(LOG_WARN, "Line too long from %s, closing", peer);
+            out += "Line too long (at most ";
+            appendInt(out, MAX_LINE_LENGTH);
+            out += " bytes). Closing connection.\n";
+            return false;
         }
+    } catch (const std::bad_alloc&) {
+        // One client's upload must not take the server (and everyone else) down with it
+        logMessage(LOG_ERROR, "Out of memory serving %s, closing", peer);
+        std::vector<Point>().swap(input.bulkPoints);
+        return false;
     }
+    return true;
 }
 
 int main() {
     int serverSocket, clientSockets[MAXCLIENTS];
+    ClientInput clientInputs[MAXCLIENTS];
     struct sockaddr_in serverAddr, clientAddr;
     fd_set readfds, masterfds;
     socklen_t clientLen = sizeof(clientAddr);
@@ -221,7 +677,9 @@ int main() {
     }
     
     std::cout << "Convex Hull Server listening on port " << PORT << std::endl;
-    std::cout << "Available commands: Newgraph <n>, <x,y>, CH, Newpoint <x,y>, Removepoint <x,y>, Status" << std::endl;
+    std::cout << "Available commands: Newgraph <n>, <x,y>, Loadpoints <n>, CH, Newpoint <x,y>, Removepoint <x,y>, Status" << std::endl;
+
+    startLogger();
     
     // Initialize file descriptor sets
     FD_ZERO(&masterfds);
@@ -240,7 +698,7 @@ int main() {
         activity = select(maxfd + 1, &readfds, NULL, NULL, NULL);
         
         if (activity < 0) {
-            perror("select error");
+            logMessage(LOG_ERROR, "select error: %s", strerror(errno));
             continue;
         }
         
@@ -248,22 +706,24 @@ int main() {
         if (FD_ISSET(serverSocket, &readfds)) {
             int newSocket = accept(serverSocket, (struct sockaddr*)&clientAddr, &clientLen);
             if (newSocket < 0) {
-                perror("Accept failed");
+                logMessage(LOG_ERROR, "Accept failed: %s", strerror(errno));
                 continue;
             }
             
-            std::cout << "New connection from " << inet_ntoa(clientAddr.sin_addr) 
-                      << ":" << ntohs(clientAddr.sin_port) << std::endl;
+            char peer[PEER_NAME_SIZE];
+            formatPeer(clientAddr, peer, sizeof(peer));
+            logMessage(LOG_INFO, "New connection from %s", peer);
             
             // Send welcome message
             //sendToClient(newSocket, "Welcome to Convex Hull Server!");
-            sendToClient(newSocket, "Commands: Newgraph <n>, <x,y>, CH, Newpoint <x,y>, Removepoint <x,y>, Status");
+            sendToClient(newSocket, "Commands: Newgraph <n>, <x,y>, Loadpoints <n>, CH, Newpoint <x,y>, Removepoint <x,y>, Status");
             
             // Add new socket to client array
             for (i = 0; i < MAXCLIENTS; i++) {
                 if (clientSockets[i] == 0) {
                     clientSockets[i] = newSocket;
-                    std::cout << "Added client to slot " << i << std::endl;
+                    memcpy(clientInputs[i].peer, peer, sizeof(peer));
+                    logMessage(LOG_DEBUG, "Added client %s to slot %d", peer, i);
                     break;
                 }
             }
@@ -281,41 +741,27 @@ int main() {
             
             if (sd > 0 && FD_ISSET(sd, &readfds)) {
                 // Read data from client
-                valread = read(sd, buffer, BUFSIZE - 1);
-                
-                if (valread == 0) {
+                valread = read(sd, buffer, BUFSIZE);
+                bool keep = valread > 0;
+
+                if (keep) {
+                    // Run every complete command received so far
+                    ClientInput& input = clientInputs[i];
+                    keep = serveInput(input, buffer, valread, input.peer);
+
+                    // One send for every reply this read produced
+                    flushOutput(sd, input.output);
+                } else {
                     // Client disconnected
-                    getpeername(sd, (struct sockaddr*)&clientAddr, &clientLen);
-                    std::cout << "Client disconnected: " << inet_ntoa(clientAddr.sin_addr) 
-                              << ":" << ntohs(clientAddr.sin_port) << std::endl;
-                    
+                    logMessage(LOG_INFO, "Client disconnected: %s", clientInputs[i].peer);
+                }
+
+                if (!keep) {
                     // Close socket and remove from sets
                     close(sd);
                     FD_CLR(sd, &masterfds);
                     clientSockets[i] = 0;
-                    
-                } else {
-                    // Process received command
-                    buffer[valread] = '\0';
-                    
-                    // Remove newline if present
-                    std::string command(buffer);
-                    if (!command.empty() && command.back() == '\n') {
-                        command.pop_back();
-                    }
-                    if (!command.empty() && command.back() == '\r') {
-                        command.pop_back();
-                    }
-                    
-                    std::cout << "Received command: " << command << std::endl;
-                    
-                    // Process command and get response
-                    std::string response = processCommand(command);
-                    
-                    // Send response back to client
-                    sendToClient(sd, response);
-                    
-                    std::cout << "Sent response: " << response << std::endl;
+                    clientInputs[i] = ClientInput();
                 }
             }
         }
@@ -0,0 +1,35 @@
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+// Asynchronous logger for the request path.
+// logMessage formats into a fixed-size record and claims a slot of a
+// lock-free ring; a background thread turns the records into lines and
+// writes them to stdout in batches. A full ring drops the record (and
+// counts it) rather than stall the caller.
+//
+// The level comes from the CH_LOG_LEVEL environment variable
+// (debug, info, warn or error; info by default).
+
+enum LogLevel {
+    LOG_DEBUG = 0,
+    LOG_INFO = 1,
+    LOG_WARN = 2,
+    LOG_ERROR = 3
+};
+
+#define LOG_RING_SIZE 8192  // Records in the ring; a power of two
+#define LOG_TEXT_SIZE 240   // Longer messages are truncated
+
+// Starts the flusher thread; messages logged before this are dropped
+void startLogger();
+
+// Writes out every queued record and stops the flusher thread
+void stopLogger();
+
+// Whether messages at level are currently recorded
+bool logEnabled(LogLevel level);
+
+// printf-style message at level; never blocks on I/O
+void logMessage(LogLevel level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+#endif // LOGGER_HPP
@@ -4,17 +4,37 @@
 #include <unistd.h>
 #include <cstring>
 #include <iostream>
+#include <atomic>
+#include <cerrno>
+#include <sys/eventfd.h>
 
 #define MAX_FD 1024
 
+// Posted task, linked into the reactor's multi-producer queue
+struct reactorTaskNode {
+    reactorTask task;
+    void* arg;
+    reactorTaskNode* next;
+};
+
 struct reactorStruct {
     std::unordered_set<int> fds;            // Set of active file descriptors
     reactorFunc funcs[MAX_FD] = {nullptr};  // Callback functions per fd
-    bool running = false;                    // Whether the loop is running
+    reactorCtxFunc ctxFuncs[MAX_FD] = {nullptr}; // Context-carrying callbacks per fd
+    void* ctxs[MAX_FD] = {nullptr};         // Context handed to ctxFuncs
+    std::atomic<bool> running{false};        // Whether the loop is running
+    std::atomic<reactorTaskNode*> tasks{nullptr}; // Tasks posted from other threads (newest first)
+    int wakeFd = -1;                         // eventfd signalled by postToReactor
 };
 
 void* startReactor() {
     reactorStruct* r = new reactorStruct;
+    r->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (r->wakeFd < 0) {
+        perror("eventfd");
+        delete r;
+        return nullptr;
+    }
     r->running = true;  // Start running immediately
     return static_cast<void*>(r);
 }
@@ -24,6 +44,18 @@ int addFdToReactor(void* reactor, int fd, reactorFunc func) {
     auto r = static_cast<reactorStruct*>(reactor);
     r->fds.insert(fd);
     r->funcs[fd] = func;
+    r->ctxFuncs[fd] = nullptr;
+    r->ctxs[fd] = nullptr;
+    return 0;
+}
+
+int addFdToReactorCtx(void* reactor, int fd, reactorCtxFunc func, void* ctx) {
+    if (!reactor || fd < 0 || fd >= MAX_FD) return -1;
+    auto r = static_cast<reactorStruct*>(reactor);
+    r->fds.insert(fd);
+    r->funcs[fd] = nullptr;
+    r->ctxFuncs[fd] = func;
+    r->ctxs[fd] = ctx;
     return 0;
 }
 
@@ -32,6 +64,8 @@ int removeFdFromReactor(void* reactor, int fd) {
     auto r = static_cast<reactorStruct*>(reactor);
     r->fds.erase(fd);
     r->funcs[fd] = nullptr;
+    r->ctxFuncs[fd] = nullptr;
+    r->ctxs[fd] = nullptr;
     return 0;
 }
 
@@ -39,10 +73,59 @@ int stopReactor(void* reactor) {
     if (!reactor) return -1;
     auto r = static_cast<reactorStruct*>(reactor);
     r->running = false;
+
+    // Drop tasks that never got to run
+    reactorTaskNode* node = r->tasks.exchange(nullptr);
+    while (node) {
+        reactorTaskNode* next = node->next;
+        delete node;
+        node = next;
+    }
+    close(r->wakeFd);
     delete r;
     return 0;
 }
 
+int postToReactor(void* reactor, reactorTask task, void* arg) {
+    if (!reactor || !task) return -1;
+    auto r = static_cast<reactorStruct*>(reactor);
+    if (!r->running) return -1;
+
+    // Lock-free push; the reactor thread takes the whole list at once
+    reactorTaskNode* node = new reactorTaskNode{task, arg, r->tasks.load(std::memory_order_relaxed)};
+    while (!r->tasks.compare_exchange_weak(node->next, node,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+    }
+
+    uint64_t one = 1;
+    if (write(r->wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("write (eventfd)");
+    }
+    return 0;
+}
+
+// Run all tasks posted so far, oldest first
+static void runPostedTasks(reactorStruct* r) {
+    reactorTaskNode* node = r->tasks.exchange(nullptr, std::memory_order_acquire);
+
+    // The queue is a stack, reverse it to keep posting order
+    reactorTaskNode* ordered = nullptr;
+    while (node) {
+        reactorTaskNode* next = node->next;
+        node->next = ordered;
+        ordered = node;
+        node = next;
+    }
+
+    while (ordered) {
+        reactorTaskNode* next = ordered->next;
+        ordered->task(ordered->arg);
+        delete ordered;
+        ordered = next;
+    }
+}
+
 // Run one iteration of the reactor event loop
 int runReactorOnce(void* reactor) {
     if (!reactor) return -1;
@@ -53,7 +136,8 @@ int runReactorOnce(void* reactor) {
     fd_set readfds;
     struct timeval tv;
     FD_ZERO(&readfds);
-    int maxfd = 0;
+    FD_SET(r->wakeFd, &readfds);
+    int maxfd = r->wakeFd;
 
     for (int fd : r->fds) {
         FD_SET(fd, &readfds);
@@ -70,11 +154,21 @@ int runReactorOnce(void* reactor) {
         return -1;
     }
 
+    if (FD_ISSET(r->wakeFd, &readfds)) {
+        uint64_t pending;
+        if (read(r->wakeFd, &pending, sizeof(pending)) < 0 && errno != EAGAIN) {
+            perror("read (eventfd)");
+        }
+    }
+    runPostedTasks(r);
+
     auto fds = r->fds;  // Copy to avoid iterator invalidation
     for (int fd : fds) {
         if (FD_ISSET(fd, &readfds)) {
             if (r->funcs[fd]) {
                 r->funcs[fd](fd);
+            } else if (r->ctxFuncs[fd]) {
+                r->ctxFuncs[fd](fd, r->ctxs[fd]);
             }
         }
     }
@@ -4,12 +4,18 @@
 // Function pointer type definition
 typedef void* (*reactorFunc)(int fd);
 
+// Callback type that also receives the context registered with the fd
+typedef void* (*reactorCtxFunc)(int fd, void* ctx);
+
 // Starts new reactor and returns pointer to it
 void* startReactor();
 
 // Adds fd to reactor (for reading); returns 0 on success
 int addFdToReactor(void* reactor, int fd, reactorFunc func);
 
+// Adds fd to reactor with a context pointer handed back to func; returns 0 on success
+int addFdToReactorCtx(void* reactor, int fd, reactorCtxFunc func, void* ctx);
+
 // Removes fd from reactor
 int removeFdFromReactor(void* reactor, int fd);
 
@@ -19,4 +25,11 @@ int stopReactor(void* reactor);
 // Run one iteration of the reactor event loop
 int runReactorOnce(void* reactor);
 
+// Task type run on the reactor thread by postToReactor
+typedef void (*reactorTask)(void* arg);
+
+// Queues task(arg) to run on the reactor thread and wakes the loop.
+// Safe to call from any thread while the reactor is alive; returns 0 on success
+int postToReactor(void* reactor, reactorTask task, void* arg);
+
 #endif
\ No newline at end of file
@@ -8,6 +8,9 @@
 #include <chrono>
 #include <cassert>
 #include <fcntl.h>
+#include <thread>
+#include <vector>
+#include <pthread.h>
 
 // Test callback function
 void* testCallback(int fd) {
@@ -77,6 +80,150 @@ void testErrorConditions() {
     std::cout << "✓ Invalid fd tests passed" << std::endl;
 }
 
+// Context callback: counts bytes read into the context it was registered with
+void* countingCallback(int fd, void* ctx) {
+    char buffer[256];
+    int bytesRead = read(fd, buffer, sizeof(buffer));
+    if (bytesRead > 0) {
+        *static_cast<int*>(ctx) += bytesRead;
+    }
+    return nullptr;
+}
+
+// Test that two reactors with context callbacks keep independent state
+void testContextCallbacks() {
+    std::cout << "\n=== Testing Context Callbacks ===" << std::endl;
+
+    void* reactorA = startReactor();
+    void* reactorB = startReactor();
+    assert(reactorA != nullptr && reactorB != nullptr);
+
+    int pipeA[2], pipeB[2];
+    if (pipe(pipeA) == -1 || pipe(pipeB) == -1) {
+        perror("pipe");
+        return;
+    }
+
+    int countA = 0, countB = 0;
+    assert(addFdToReactorCtx(reactorA, pipeA[0], countingCallback, &countA) == 0);
+    assert(addFdToReactorCtx(reactorB, pipeB[0], countingCallback, &countB) == 0);
+    assert(addFdToReactorCtx(nullptr, pipeA[0], countingCallback, &countA) == -1);
+    assert(addFdToReactorCtx(reactorA, -1, countingCallback, &countA) == -1);
+    std::cout << "✓ addFdToReactorCtx test passed" << std::endl;
+
+    assert(write(pipeA[1], "abc", 3) == 3);
+    assert(write(pipeB[1], "hello", 5) == 5);
+
+    for (int i = 0; i < 3; i++) {
+        runReactorOnce(reactorA);
+        runReactorOnce(reactorB);
+    }
+    assert(countA == 3);
+    assert(countB == 5);
+    std::cout << "✓ Independent reactor contexts test passed" << std::endl;
+
+    assert(removeFdFromReactor(reactorA, pipeA[0]) == 0);
+    assert(removeFdFromReactor(reactorB, pipeB[0]) == 0);
+    stopReactor(reactorA);
+    stopReactor(reactorB);
+
+    close(pipeA[0]);
+    close(pipeA[1]);
+    close(pipeB[0]);
+    close(pipeB[1]);
+}
+
+// Posted task argument: which producer posted it and in what order
+struct postedTask {
+    int producer;
+    int seq;
+};
+
+struct postTestState {
+    pthread_t reactorThread;
+    int lastSeq[4];
+    int executed;
+    bool ordered;
+    bool onReactorThread;
+};
+
+postTestState postState;
+
+void recordPostedTask(void* arg) {
+    postedTask* task = static_cast<postedTask*>(arg);
+    if (!pthread_equal(pthread_self(), postState.reactorThread)) postState.onReactorThread = false;
+    if (task->seq != postState.lastSeq[task->producer] + 1) postState.ordered = false;
+    postState.lastSeq[task->producer] = task->seq;
+    postState.executed++;
+    delete task;
+}
+
+// Test tasks posted from several threads run on the reactor thread in posting order
+void testPostToReactor() {
+    std::cout << "\n=== Testing postToReactor ===" << std::endl;
+
+    // Calls stay outside assert(), so the test still posts under -DNDEBUG
+    int posted = postToReactor(nullptr, recordPostedTask, nullptr);
+    assert(posted == -1);
+
+    void* reactor = startReactor();
+    assert(reactor != nullptr);
+    posted = postToReactor(reactor, nullptr, nullptr);
+    assert(posted == -1);
+    (void)posted;
+
+    const int producers = 4;
+    int perProducer = 1000;
+    postState.reactorThread = pthread_self();
+    for (int i = 0; i < producers; i++) postState.lastSeq[i] = -1;
+    postState.executed = 0;
+    postState.ordered = true;
+    postState.onReactorThread = true;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([reactor, p, perProducer]() {
+            for (int i = 0; i < perProducer; i++) {
+                int result = postToReactor(reactor, recordPostedTask, new postedTask{p, i});
+                assert(result == 0);
+                (void)result;
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    while (postState.executed < producers * perProducer &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+        runReactorOnce(reactor);
+    }
+    for (auto& t : threads) t.join();
+    runReactorOnce(reactor);
+
+    assert(postState.executed == producers * perProducer);
+    assert(postState.ordered);
+    assert(postState.onReactorThread);
+    std::cout << "✓ " << postState.executed << " posted tasks ran in order on the reactor thread" << std::endl;
+
+    // A post from another thread must wake a reactor blocked in select,
+    // rather than wait for its 100 ms timeout
+    std::chrono::steady_clock::time_point postedAt;
+    std::thread late([reactor, perProducer, &postedAt]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        postedAt = std::chrono::steady_clock::now();
+        postToReactor(reactor, recordPostedTask, new postedTask{0, perProducer});
+    });
+    while (postState.executed == producers * perProducer) {
+        runReactorOnce(reactor);
+    }
+    auto ranAt = std::chrono::steady_clock::now();
+    late.join(); // postedAt is set from here on
+    auto waited = std::chrono::duration_cast<std::chrono::microseconds>(ranAt - postedAt);
+    assert(waited < std::chrono::milliseconds(30));
+    std::cout << "✓ Wakeup after post took " << waited.count() << " us" << std::endl;
+
+    stopReactor(reactor);
+}
+
 // Add this new callback function specifically for server socket
 void* serverSocketCallback(int fd) {
     std::cout << "Server callback triggered for fd: " << fd << std::endl;
@@ -172,6 +319,8 @@ int main() {
     try {
         testReactor();
         testErrorConditions();
+        testContextCallbacks();
+        testPostToReactor();
         testSocketReactor();
         
         std::cout << "\n🎉 ALL TESTS PASSED! 🎉" << std::endl;
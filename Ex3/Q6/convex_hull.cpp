@@ -1,33 +1,33 @@
 #include "reactor.hpp"
 #include "convex_hull.hpp"
+#include "monotone_chain.hpp"
+#include "logger.hpp"
 #include <iostream>
 #include <vector>
 #include <string>
-#include <sstream>
 #include <algorithm>
+#include <new>
 #include <cmath>
-#include <iomanip>
+#include <cstdlib>
+#include <cstdint>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
+#include <cstdio>
+#include <cerrno>
 #include <fcntl.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 #include <map>
+#include <memory>
 
 
 #define PORT 9034
 #define MAXCLIENTS 10
-#define BUFSIZE 1024
-
-// Reactor globals
-void* globalReactor = nullptr;
-std::map<int, bool> clientSockets;
-int serverSocket = -1;
-
-// Global graph data structure shared by all clients
-std::vector<Point> globalGraph;
-int counter = 0;
+#define BUFSIZE 65536
 
 Point::Point(double x, double y) : x(x), y(y) {}
 
@@ -47,35 +47,8 @@ double crossProduct(const Point& O, const Point& A, const Point& B) {
 
 // Calculate convex hull using Andrew's monotone chain algorithm
 std::vector<Point> convexHull(std::vector<Point> points) {
-    int n = points.size();
-    if (n <= 1) return points;
-    
-    // Sort points lexicographically
-    std::sort(points.begin(), points.end());
-    
-    // Build lower hull
     std::vector<Point> hull;
-    for (int i = 0; i < n; i++) {
-        while (hull.size() >= 2 && 
-               crossProduct(hull[hull.size()-2], hull[hull.size()-1], points[i]) <= 0) {
-            hull.pop_back();
-        }
-        hull.push_back(points[i]);
-    }
-    
-    // Build upper hull
-    size_t t = hull.size() + 1;
-    for (int i = n - 2; i >= 0; i--) {
-        while (hull.size() >= t && 
-               crossProduct(hull[hull.size()-2], hull[hull.size()-1], points[i]) <= 0) {
-            hull.pop_back();
-        }
-        hull.push_back(points[i]);
-    }
-    
-    // Remove the last point because it's the same as the first
-    hull.pop_back();
-    
+    monotoneChain(points, hull);
     return hull;
 }
 
@@ -94,147 +67,830 @@ double polygonArea(const std::vector<Point>& vertices) {
     return std::abs(area) / 2.0;
 }
 
+// Whitespace as accepted around numbers (C locale, no function call)
+static inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// '0'..'9' with a single comparison
+static inline bool isDigit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// Powers of ten that are exact doubles
+static const double exactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Parse a decimal number (sign, fraction, exponent) starting at p, skipping
+// leading whitespace. Returns the position after it, or nullptr if there is
+// no finite number there. Never allocates and ignores the locale.
+const char* parseDouble(const char* p, const char* end, double& value) {
+    while (p < end && isSpace(*p)) p++;
+    const char* start = p;
+
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    // Accumulate every digit; only trusted below when there are at most 19
+    uint64_t mantissa = 0;
+    const char* digitsStart = p;
+    while (p < end && isDigit(*p)) {
+        mantissa = mantissa * 10 + (*p - '0');
+        p++;
+    }
+    int digits = static_cast<int>(p - digitsStart);
+    int exponent = 0;  // Power of ten applied to mantissa
+    if (p < end && *p == '.') {
+        const char* fraction = ++p;
+        while (p < end && isDigit(*p)) {
+            mantissa = mantissa * 10 + (*p - '0');
+            p++;
+        }
+        exponent = -static_cast<int>(p - fraction);
+        digits -= exponent;
+    }
+    if (digits == 0) return nullptr;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool expNegative = false;
+        if (q < end && (*q == '+' || *q == '-')) {
+            expNegative = (*q == '-');
+            q++;
+        }
+        if (q < end && isDigit(*q)) {
+            int e = 0;
+            for (; q < end && isDigit(*q); q++) {
+                if (e < 100000) e = e * 10 + (*q - '0');
+            }
+            exponent += expNegative ? -e : e;
+            p = q;
+        }
+    }
+
+    // Exact when both the mantissa and the power of ten are exact doubles
+    if (digits <= 19 && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        double v = static_cast<double>(mantissa);
+        v = exponent < 0 ? v / exactPowersOfTen[-exponent] : v * exactPowersOfTen[exponent];
+        value = negative ? -v : v;
+        return p;
+    }
+
+    // Rare long or extreme inputs: let strtod round them correctly
+    char text[128];
+    size_t len = p - start;
+    if (len >= sizeof(text)) return nullptr;
+    memcpy(text, start, len);
+    text[len] = '\0';
+    value = strtod(text, nullptr);
+    if (!std::isfinite(value)) return nullptr;
+    return p;
+}
+
+// Parse point "x,y" from [begin, end); whitespace around the numbers is allowed
+bool parsePoint(const char* begin, const char* end, Point& point) {
+    double x, y;
+    const char* p = parseDouble(begin, end, x);
+    if (!p) return false;
+    while (p < end && isSpace(*p)) p++;
+    if (p == end || *p != ',') return false;
+
+    p = parseDouble(p + 1, end, y);
+    if (!p) return false;
+    while (p < end && isSpace(*p)) p++;
+    if (p != end) return false;
+
+    point = Point(x, y);
+    return true;
+}
+
 // Parse point from string "x,y"
-Point parsePoint(const std::string& pointStr) {
-    size_t commaPos = pointStr.find(',');
-    if (commaPos != std::string::npos) {
-        double x = std::stod(pointStr.substr(0, commaPos));
-        double y = std::stod(pointStr.substr(commaPos + 1));
-        return Point(x, y);
+bool parsePoint(const std::string& pointStr, Point& point) {
+    return parsePoint(pointStr.data(), pointStr.data() + pointStr.size(), point);
+}
+
+// Bitmask of the whitespace bytes among the 64 bytes at p (bit i = p[i]);
+// a window cut short by end only reports the bytes before end
+static uint64_t whitespaceBits(const char* p, const char* end) {
+    if (end - p < 64) {
+        uint64_t bits = 0;
+        for (int i = 0; p + i < end; i++) {
+            if (isSpace(p[i])) bits |= 1ULL << i;
+        }
+        return bits;
+    }
+#if defined(__AVX2__)
+    // ' ' or '\t'..'\r'; bytes >= 0x80 compare as negative and never match
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i low = _mm256_set1_epi8('\t' - 1);
+    const __m256i high = _mm256_set1_epi8('\r' + 1);
+    uint64_t bits = 0;
+    for (int i = 0; i < 64; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+            _mm256_and_si256(_mm256_cmpgt_epi8(v, low), _mm256_cmpgt_epi8(high, v)));
+        bits |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(ws))) << i;
     }
-    return Point(0, 0);
+    return bits;
+#elif defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i low = _mm_set1_epi8('\t' - 1);
+    const __m128i high = _mm_set1_epi8('\r' + 1);
+    uint64_t bits = 0;
+    for (int i = 0; i < 64; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+            _mm_and_si128(_mm_cmpgt_epi8(v, low), _mm_cmplt_epi8(v, high)));
+        bits |= static_cast<uint64_t>(_mm_movemask_epi8(ws)) << i;
+    }
+    return bits;
+#else
+    uint64_t bits = 0;
+    for (int i = 0; i < 64; i++) {
+        if (isSpace(p[i])) bits |= 1ULL << i;
+    }
+    return bits;
+#endif
+}
+
+size_t scanPoints(const char* begin, const char* end, long& pending,
+                  std::vector<Point>& points, bool& invalid) {
+    const char* p = begin;      // Start of the current token (or whitespace before it)
+    bool prevSpace = true;      // Whether the byte before the window is whitespace
+
+    for (const char* base = begin; pending > 0 && base < end; base += 64) {
+        uint64_t space = whitespaceBits(base, end);
+        // A token ends at each whitespace byte that follows a non-whitespace one
+        uint64_t ends = space & ~((space << 1) | (prevSpace ? 1 : 0));
+        prevSpace = (space >> 63) != 0;
+
+        while (ends && pending > 0) {
+            const char* stop = base + __builtin_ctzll(ends);
+            ends &= ends - 1;
+
+            // parsePoint skips the whitespace in front of the token itself
+            Point point;
+            if (parsePoint(p, stop, point)) {
+                points.push_back(point);
+            } else {
+                invalid = true;
+            }
+            pending--;
+            p = stop;
+        }
+    }
+
+    // A token without a whitespace after it may continue in the next read
+    return p - begin;
+}
+
+// "ip:port" of a client, formatted once per connection for log lines
+void formatPeer(const struct sockaddr_in& addr, char* text, size_t size) {
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+    snprintf(text, size, "%s:%u", ip, static_cast<unsigned>(ntohs(addr.sin_port)));
 }
 
 // Send message to a specific client
 void sendToClient(int clientSocket, const std::string& message) {
     std::string msg = message + "\n";
-    send(clientSocket, msg.c_str(), msg.length(), 0);
+    send(clientSocket, msg.c_str(), msg.length(), MSG_NOSIGNAL);
 }
 
-// Process command from a client and return response
-std::string processCommand(const std::string& command) {
-    std::istringstream iss(command);
-    std::string cmd;
-    iss >> cmd;
-    
-    if (cmd == "Newgraph") {
-        int n;
-        iss >> n;
-        
-        // Clear the global graph and prepare for new points
-        globalGraph.clear();
-        globalGraph.reserve(n);
-        
-        counter = n; // Set counter for expected points
-        if (n <= 0) {
-            return "Invalid number of points. Please specify a positive integer.";
-        }
-        return "Ready for " + std::to_string(n) + " points. Send points one by one.";
-        
-    } else if (cmd == "CH") {
-        // Calculate and return convex hull area
-        std::vector<Point> hull = convexHull(globalGraph);
-        double area = polygonArea(hull);
-        
-        std::ostringstream oss;
-        oss << std::fixed << std::setprecision(1) << area;
-        return "Convex Hull Area: " + oss.str();
-        
-    } else if (cmd == "Newpoint") {
-        // Add a new point to existing graph
-        std::string pointStr;
-        iss >> pointStr;
-        Point newPoint = parsePoint(pointStr);
-        globalGraph.push_back(newPoint);
-        
-        return "New point added: (" + std::to_string(newPoint.x) + "," + std::to_string(newPoint.y) + ")";
-        
-    } else if (cmd == "Removepoint") {
-        // Remove a point from the graph
-        std::string pointStr;
-        iss >> pointStr;
-        Point pointToRemove = parsePoint(pointStr);
-        
-        // Find and remove the point
-        auto it = std::find(globalGraph.begin(), globalGraph.end(), pointToRemove);
-        if (it != globalGraph.end()) {
-            globalGraph.erase(it);
-            return "Point removed: (" + std::to_string(pointToRemove.x) + "," + std::to_string(pointToRemove.y) + ")";
+void appendInt(std::string& out, long long value) {
+    char text[24];
+    char* end = text + sizeof(text);
+    char* p = end;
+    unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : value;
+    do {
+        *--p = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) *--p = '-';
+    out.append(p, end - p);
+}
+
+static const double decimalScales[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+
+void appendFixed(std::string& out, double value, int decimals) {
+    double scaled = std::fabs(value) * (decimals >= 0 && decimals <= 6 ? decimalScales[decimals] : 0);
+    double whole = std::floor(scaled);
+    double fraction = scaled - whole;
+
+    // Large values, NaN/inf and near-ties need printf's exact rounding
+    if (decimals < 0 || decimals > 6 || !(scaled < 1e12) || std::fabs(fraction - 0.5) < 1e-3) {
+        char text[512];
+        int n = snprintf(text, sizeof(text), "%.*f", decimals, value);
+        if (n > 0) out.append(text, std::min(static_cast<size_t>(n), sizeof(text) - 1));
+        return;
+    }
+
+    uint64_t units = static_cast<uint64_t>(whole) + (fraction > 0.5 ? 1 : 0);
+    char text[32];
+    char* end = text + sizeof(text);
+    char* p = end;
+    for (int i = 0; i < decimals; i++) {
+        *--p = static_cast<char>('0' + units % 10);
+        units /= 10;
+    }
+    if (decimals > 0) *--p = '.';
+    do {
+        *--p = static_cast<char>('0' + units % 10);
+        units /= 10;
+    } while (units);
+    if (std::signbit(value)) *--p = '-';
+    out.append(p, end - p);
+}
+
+void appendPoint(std::string& out, const Point& point) {
+    out += '(';
+    appendFixed(out, point.x, 6);
+    out += ',';
+    appendFixed(out, point.y, 6);
+    out += ')';
+}
+
+// Calculate convex hull area and format the CH response
+void appendHullArea(std::string& out, std::vector<Point> points) {
+    std::vector<Point> hull = convexHull(std::move(points));
+    out += "Convex Hull Area: ";
+    appendFixed(out, polygonArea(hull), 1);
+}
+
+// Append received bytes, dropping what earlier reads already consumed
+void appendInput(ClientInput& input, const char* data, size_t len) {
+    if (input.pos > 0) {
+        input.buffer.erase(0, input.pos);
+        input.pos = 0;
+    }
+    input.buffer.append(data, len);
+}
+
+// Take the next newline-terminated command off the input
+bool nextLine(ClientInput& input, std::string& line) {
+    size_t newline = input.buffer.find('\n', input.pos);
+    if (newline == std::string::npos) return false;
+
+    line.assign(input.buffer, input.pos, newline - input.pos);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    input.pos = newline + 1;
+    return true;
+}
+
+// Whether the unconsumed input is longer than any command line or payload point
+// may be; only meaningful once every complete line has been taken off
+bool lineTooLong(const ClientInput& input) {
+    return input.buffer.size() - input.pos > MAX_LINE_LENGTH;
+}
+
+// Parse "Loadpoints <n>"; the n points follow as one payload
+void startBulkLoad(ClientInput& input, const char* args, const char* end, std::string& out) {
+    long n;
+    if (!parseInteger(nextToken(args, end), n) || n <= 0) {
+        out += "Invalid number of points. Please specify a positive integer.";
+        return;
+    }
+    if (n > MAX_LOAD_POINTS) {
+        out += "Too many points for one Loadpoints (at most ";
+        appendInt(out, MAX_LOAD_POINTS);
+        out += ").";
+        return;
+    }
+
+    input.pendingPoints = n;
+    input.bulkInvalid = false;
+    input.bulkPoints.clear();
+    // n is only the client's word: larger uploads grow as their points arrive
+    input.bulkPoints.reserve(std::min(n, static_cast<long>(LOAD_RESERVE_POINTS)));
+}
+
+// Parse the payload points received so far ("x,y" separated by whitespace)
+bool consumeBulkPoints(ClientInput& input) {
+    const char* data = input.buffer.data();
+    input.pos += scanPoints(data + input.pos, data + input.buffer.size(),
+                            input.pendingPoints, input.bulkPoints, input.bulkInvalid);
+    return input.pendingPoints == 0;
+}
+
+void finishBulkLoad(ServerState& state, ClientInput& input, std::string& out) {
+    if (input.bulkInvalid) {
+        std::vector<Point>().swap(input.bulkPoints);
+        out += "Invalid point format in Loadpoints payload. Graph unchanged.\n";
+        return;
+    }
+
+    size_t loaded = input.bulkPoints.size();
+    state.graph.swap(input.bulkPoints);
+    state.counter = 0;
+
+    // Release the previous graph now held by the input
+    std::vector<Point>().swap(input.bulkPoints);
+    out += "Graph loaded with ";
+    appendInt(out, loaded);
+    out += " points.\n";
+}
+
+// Next whitespace-separated token at or after p; empty at the end of the line
+Token nextToken(const char*& p, const char* end) {
+    while (p < end && isSpace(*p)) p++;
+    Token token;
+    token.begin = p;
+    while (p < end && !isSpace(*p)) p++;
+    token.end = p;
+    return token;
+}
+
+// Whether the token is exactly word
+static bool tokenEquals(const Token& token, const char* word) {
+    size_t length = strlen(word);
+    return static_cast<size_t>(token.end - token.begin) == length && memcmp(token.begin, word, length) == 0;
+}
+
+// Parse a whole token as an integer of at most 9 digits
+bool parseInteger(const Token& token, long& value) {
+    const char* p = token.begin;
+    bool negative = p < token.end && *p == '-';
+    if (negative || (p < token.end && *p == '+')) p++;
+    if (p == token.end || token.end - p > 9) return false;
+
+    long v = 0;
+    for (; p < token.end; p++) {
+        if (!isDigit(*p)) return false;
+        v = v * 10 + (*p - '0');
+    }
+    value = negative ? -v : v;
+    return true;
+}
+
+// Command handlers; [args, end) is the rest of the line after the command word.
+// Each appends its reply, without the newline, to out
+
+static void cmdNewgraph(ServerState& state, ClientInput&, const char* args, const char* end, std::string& out) {
+    long n;
+    if (!parseInteger(nextToken(args, end), n)) n = 0;
+
+    // Clear the graph and prepare for new points
+    state.graph.clear();
+    if (n > 0) state.graph.reserve(n);
+
+    state.counter = n; // Set counter for expected points
+    if (n <= 0) {
+        out += "Invalid number of points. Please specify a positive integer.";
+        return;
+    }
+    out += "Ready for ";
+    appendInt(out, n);
+    out += " points. Send points one by one.";
+}
+
+static void cmdCH(ServerState& state, ClientInput&, const char*, const char*, std::string& out) {
+    // Calculate and return convex hull area
+    appendHullArea(out, state.graph);
+}
+
+static void cmdNewpoint(ServerState& state, ClientInput&, const char* args, const char* end, std::string& out) {
+    // Add a new point to existing graph
+    Token pointArg = nextToken(args, end);
+    Point newPoint;
+    if (!parsePoint(pointArg.begin, pointArg.end, newPoint)) {
+        out += "Invalid point format. Please use 'Newpoint <x,y>'.";
+        return;
+    }
+
+    state.graph.push_back(newPoint);
+    out += "New point added: ";
+    appendPoint(out, newPoint);
+}
+
+static void cmdRemovepoint(ServerState& state, ClientInput&, const char* args, const char* end, std::string& out) {
+    // Remove a point from the graph
+    Token pointArg = nextToken(args, end);
+    Point pointToRemove;
+    if (!parsePoint(pointArg.begin, pointArg.end, pointToRemove)) {
+        out += "Invalid point format. Please use 'Removepoint <x,y>'.";
+        return;
+    }
+
+    // Find and remove the point
+    auto it = std::find(state.graph.begin(), state.graph.end(), pointToRemove);
+    if (it != state.graph.end()) {
+        state.graph.erase(it);
+        out += "Point removed: ";
+    } else {
+        out += "Point not found: ";
+    }
+    appendPoint(out, pointToRemove);
+}
+
+static void cmdStatus(ServerState& state, ClientInput&, const char*, const char*, std::string& out) {
+    // Return current graph status
+    out += "Current graph has ";
+    appendInt(out, state.graph.size());
+    out += " points";
+}
+
+// The payload that follows is read by the input loop; nothing to reply until it is in
+static void cmdLoadpoints(ServerState&, ClientInput& input, const char* args, const char* end, std::string& out) {
+    startBulkLoad(input, args, end, out);
+}
+
+#define COMMAND(name, handler) { name, sizeof(name) - 1, handler }
+
+// Every text command; adding one is a new row here
+static constexpr CommandEntry commandTable[] = {
+    COMMAND("Newgraph", cmdNewgraph),
+    COMMAND("CH", cmdCH),
+    COMMAND("Newpoint", cmdNewpoint),
+    COMMAND("Removepoint", cmdRemovepoint),
+    COMMAND("Status", cmdStatus),
+    COMMAND("Loadpoints", cmdLoadpoints)
+};
+
+static constexpr size_t commandCount = sizeof(commandTable) / sizeof(commandTable[0]);
+
+#define COMMAND_SLOTS 64
+
+// Dispatch slot of a command word, from its length and first and last characters
+static constexpr unsigned commandSlot(const char* word, size_t length) {
+    return (length * 5 + static_cast<unsigned char>(word[0]) +
+            static_cast<unsigned char>(word[length - 1]) * 2) % COMMAND_SLOTS;
+}
+
+// Index of the command in slot, or -1
+static constexpr int commandInSlot(unsigned slot, size_t i = 0) {
+    return i == commandCount ? -1
+         : commandSlot(commandTable[i].name, commandTable[i].length) == slot ? static_cast<int>(i)
+         : commandInSlot(slot, i + 1);
+}
+
+// True if every command has a slot of its own
+static constexpr bool slotsDistinct(size_t i = 0) {
+    return i == commandCount ||
+           (commandInSlot(commandSlot(commandTable[i].name, commandTable[i].length)) == static_cast<int>(i) &&
+            slotsDistinct(i + 1));
+}
+
+static_assert(slotsDistinct(), "Two commands share a dispatch slot; change commandSlot");
+
+#define SLOT_ROW(n) commandInSlot(n), commandInSlot(n + 1), commandInSlot(n + 2), commandInSlot(n + 3), \
+                    commandInSlot(n + 4), commandInSlot(n + 5), commandInSlot(n + 6), commandInSlot(n + 7)
+
+// Slot -> commandTable index, computed by the compiler
+static constexpr signed char commandSlots[COMMAND_SLOTS] = {
+    SLOT_ROW(0), SLOT_ROW(8), SLOT_ROW(16), SLOT_ROW(24),
+    SLOT_ROW(32), SLOT_ROW(40), SLOT_ROW(48), SLOT_ROW(56)
+};
+
+const CommandEntry* findCommand(const char* word, size_t length) {
+    if (length == 0) return nullptr;
+    int index = commandSlots[commandSlot(word, length)];
+    if (index < 0) return nullptr;
+
+    const CommandEntry& entry = commandTable[index];
+    if (entry.length != length || memcmp(entry.name, word, length) != 0) return nullptr;
+    return &entry;
+}
+
+// Process command from a client and append the response line to out
+void processCommand(ServerState& state, ClientInput& input, const std::string& command, std::string& out) {
+    // While a graph is being filled nearly every line is a point; skip the tokenizer for those
+    Point newPoint;
+    if (state.counter > 0 && parsePoint(command, newPoint)) {
+        state.graph.push_back(newPoint);
+        state.counter--;
+        out += "Point added: ";
+        appendPoint(out, newPoint);
+        out += '\n';
+        return;
+    }
+
+    const char* p = command.data();
+    const char* end = p + command.size();
+    Token cmd = nextToken(p, end);
+    const CommandEntry* entry = findCommand(cmd.begin, cmd.end - cmd.begin);
+    if (entry) {
+        size_t mark = out.size();
+        entry->handler(state, input, p, end, out);
+        if (out.size() != mark) out += '\n'; // Loadpoints replies once its payload is in
+        return;
+    }
+
+    if (state.counter > 0){
+        out += "Unknown command or invalid point format. Please use one of the following commands:\n"
+            "Newgraph <n>, <x,y>, Loadpoints <n>, CH, Newpoint <x,y>, Removepoint <x,y>, Status\n";
+    } else {
+        out += "The graph is full. Please start a new graph with 'Newgraph <n>' command or add new points with 'Newpoint <x,y>'.\n";
+    }
+}
+
+std::string& replyBuffer(ClientConnection& conn) {
+    if (conn.replies.empty()) return conn.output;
+
+    // An earlier CH is still computing; hold this reply back until it is done
+    conn.replies.push_back(PendingReply());
+    conn.replies.back().ready = true;
+    conn.nextSeq++;
+    return conn.replies.back().response;
+}
+
+bool takeRequestTag(std::string& command, long& tag) {
+    tag = -1;
+    if (command[0] != '#') return true;
+
+    const char* p = command.data() + 1;
+    const char* end = command.data() + command.size();
+    Token id = nextToken(p, end);
+    if (id.begin != command.data() + 1 || !isDigit(*id.begin) || !parseInteger(id, tag)) return false;
+
+    while (p < end && isSpace(*p)) p++;
+    command.erase(0, p - command.data());
+    return !command.empty();
+}
+
+void appendTag(std::string& out, long tag) {
+    out += '#';
+    appendInt(out, tag);
+    out += ' ';
+}
+
+std::string& replyTo(ClientConnection& conn, long tag) {
+    if (tag < 0) return replyBuffer(conn);
+    appendTag(conn.output, tag);
+    return conn.output;
+}
+
+// Sends as much of conn.output as the socket takes without blocking the
+// reactor; the rest goes out from handleClientWritable as the socket drains.
+// False if the connection failed, in which case the output is dropped
+static bool sendOutput(ServerState& state, int clientSocket, ClientConnection& conn) {
+    size_t sent = 0;
+    bool failed = false;
+    while (sent < conn.output.size()) {
+        ssize_t n = send(clientSocket, conn.output.data() + sent, conn.output.size() - sent,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            sent += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
         } else {
-            return "Point not found: (" + std::to_string(pointToRemove.x) + "," + std::to_string(pointToRemove.y) + ")";
+            failed = true;
+            break;
         }
-        
-    } else if (cmd == "Status") {
-        // Return current graph status
-        return "Current graph has " + std::to_string(globalGraph.size()) + " points";
-        
+    }
+    if (failed) {
+        conn.output.clear();
     } else {
-        if (counter > 0){        
-            try {
-                Point newPoint = parsePoint(command);
-                globalGraph.push_back(newPoint);
-                counter--;
-                return "Point added: (" + std::to_string(newPoint.x) + "," + std::to_string(newPoint.y) + ")";
-            } catch (...) {
-                return "Unknown command or invalid point format. Please use one of the following commands:\n"
-                    "Newgraph <n>, <x,y>, CH, Newpoint <x,y>, Removepoint <x,y>, Status";
-            }
+        conn.output.erase(0, sent); // Keeps the capacity for the next batch
+    }
+
+    bool waiting = !conn.output.empty();
+    if (waiting != conn.writeWaiting) {
+        if (waiting) {
+            addWriteFdToReactorCtx(state.reactor, clientSocket, handleClientWritable, &state);
         } else {
-            return "The graph is full. Please start a new graph with 'Newgraph <n>' command or add new points with 'Newpoint <x,y>'.";
+            removeWriteFdFromReactor(state.reactor, clientSocket);
+        }
+        conn.writeWaiting = waiting;
+    }
+
+    // A client that sends requests without reading the replies is not read
+    // from until it catches up, so its output cannot grow without bound
+    if (!conn.closing && !conn.readPaused && conn.output.size() > MAX_PENDING_OUTPUT) {
+        removeFdFromReactor(state.reactor, clientSocket);
+        conn.readPaused = true;
+    } else if (!conn.closing && conn.readPaused && !waiting) {
+        addFdToReactorCtx(state.reactor, clientSocket, handleClientData, &state);
+        conn.readPaused = false;
+    }
+    return !failed;
+}
+
+void flushReplies(ServerState& state, int clientSocket) {
+    auto it = state.clientSockets.find(clientSocket);
+    if (it == state.clientSockets.end()) return;
+
+    ClientConnection& conn = it->second;
+    while (!conn.replies.empty() && conn.replies.front().ready) {
+        const std::string& response = conn.replies.front().response;
+        logMessage(LOG_DEBUG, "Sent response to %s: %.*s", conn.peer,
+                   static_cast<int>(response.size() - 1), response.data());
+        conn.output += response;
+        conn.replies.pop_front();
+    }
+    if (!sendOutput(state, clientSocket, conn) && !conn.closing) {
+        // Nobody is left to read the rest, whether or not a read noticed yet
+        removeFdFromReactor(state.reactor, clientSocket);
+        conn.closing = true;
+        conn.replies.clear();
+    }
+
+    // Replies still being sent keep the connection until the socket took them
+    if (conn.closing && conn.replies.empty() && conn.taggedInFlight == 0 && conn.output.empty()) {
+        logMessage(LOG_INFO, "Client disconnected: %s", conn.peer);
+        state.clientSockets.erase(it);
+        close(clientSocket);
+    }
+}
+
+// Finished CH travelling from a worker back to the reactor thread
+struct HullResult {
+    ServerState* state;
+    int clientSocket;
+    unsigned long connectionId;
+    unsigned long seq;
+    long tag;
+    std::string response;
+};
+
+// Runs on the reactor thread via postToReactor
+static void deliverHullReply(void* arg) {
+    HullResult* result = static_cast<HullResult*>(arg);
+    ServerState& state = *result->state;
+
+    auto it = state.clientSockets.find(result->clientSocket);
+    if (it != state.clientSockets.end() && it->second.id == result->connectionId) {
+        ClientConnection& conn = it->second;
+        if (result->tag >= 0) {
+            // Tagged: goes out now, ahead of any untagged reply still held back
+            conn.taggedInFlight--;
+            logMessage(LOG_DEBUG, "Sent response to %s: %.*s", conn.peer,
+                       static_cast<int>(result->response.size() - 1), result->response.data());
+            conn.output += result->response;
+        } else if (result->seq >= conn.nextSeq - conn.replies.size()) {
+            unsigned long frontSeq = conn.nextSeq - conn.replies.size();
+            PendingReply& reply = conn.replies[result->seq - frontSeq];
+            reply.ready = true;
+            reply.response = result->response;
         }
+        // Otherwise its slot was dropped when the connection was reset
+        flushReplies(state, result->clientSocket);
     }
+    // Otherwise the client left while the hull was computing
+    delete result;
 }
 
-void* handleClientData(int clientSocket) {
+void offloadConvexHull(ServerState& state, int clientSocket, long tag) {
+    ClientConnection& conn = state.clientSockets[clientSocket];
+    unsigned long seq = 0;
+    if (tag < 0) {
+        conn.replies.push_back(PendingReply());
+        seq = conn.nextSeq++;
+    } else {
+        conn.taggedInFlight++;
+    }
+
+    HullResult* result = new HullResult{&state, clientSocket, conn.id, seq, tag, std::string()};
+    if (tag >= 0) appendTag(result->response, tag);
+    std::shared_ptr<std::vector<Point>> snapshot = std::make_shared<std::vector<Point>>(state.graph);
+
+    state.pool->submit([result, snapshot]() {
+        appendHullArea(result->response, std::move(*snapshot));
+        result->response += '\n';
+        if (postToReactor(result->state->reactor, deliverHullReply, result) != 0) {
+            delete result;
+        }
+    });
+}
+
+void* handleClientData(int clientSocket, void* ctx) {
+    ServerState& state = *static_cast<ServerState*>(ctx);
     char buffer[BUFSIZE];
-    int valread = read(clientSocket, buffer, BUFSIZE - 1);
+    int valread = read(clientSocket, buffer, BUFSIZE);
 
     if (valread <= 0) {
-        // Client disconnected
-        removeFdFromReactor(globalReactor, clientSocket);
-        clientSockets.erase(clientSocket);
-        close(clientSocket);
+        // Client disconnected (or only half-closed after pipelining its requests)
+        removeFdFromReactor(state.reactor, clientSocket);
+        ClientConnection& conn = state.clientSockets[clientSocket];
+        conn.closing = true;
+        // Nobody is left to read them; the front moves up to nextSeq, so CH
+        // results still computing for the dropped slots are discarded
+        if (valread < 0) conn.replies.clear();
+        // Closes the socket now, or once the last offloaded CH has answered
+        flushReplies(state, clientSocket);
         return nullptr;
     }
 
-    buffer[valread] = '\0';
-    std::string command(buffer);
-    if (!command.empty() && command.back() == '\n') command.pop_back();
-    if (!command.empty() && command.back() == '\r') command.pop_back();
+    // Run every complete command received so far
+    ClientConnection& conn = state.clientSockets[clientSocket];
+    ClientInput& input = conn.input;
+    std::string command;
+    try {
+        appendInput(input, buffer, valread);
+        while (true) {
+            if (input.pendingPoints > 0) {
+                // Loadpoints payload: a single reply once the last point is in
+                if (!consumeBulkPoints(input)) break;
+                finishBulkLoad(state, input, replyTo(conn, input.bulkTag));
+                continue;
+            }
+            if (!nextLine(input, command)) break;
+            if (command.empty()) continue;
+
+            logMessage(LOG_DEBUG, "Received command from %s: %s", conn.peer, command.c_str());
+
+            long tag;
+            if (!takeRequestTag(command, tag)) {
+                replyBuffer(conn) += "Invalid request tag. Please use '#<id> <command>' with a non-negative id.\n";
+                continue;
+            }
+
+            const char* p = command.data();
+            Token cmd = nextToken(p, p + command.size());
+            if (tokenEquals(cmd, "CH")) {
+                // Keep the loop free for other clients while the hull is computed
+                offloadConvexHull(state, clientSocket, tag);
+            } else {
+                // A Loadpoints started here answers under this tag once its payload is in
+                input.bulkTag = tag;
+                std::string& out = tag < 0 ? replyBuffer(conn) : conn.output;
+                size_t mark = out.size();
+                if (tag >= 0) appendTag(out, tag);
+                size_t body = out.size();
+                processCommand(state, input, command, out);
+                if (out.size() == body) {
+                    // No reply yet, so no tag either
+                    out.resize(mark);
+                    continue;
+                }
+                logMessage(LOG_DEBUG, "Sent response to %s: %.*s", conn.peer,
+                           static_cast<int>(out.size() - mark - 1), out.data() + mark);
+            }
+        }
 
-    std::cout << "Received command: " << command << std::endl;
-    std::string response = processCommand(command);
-    sendToClient(clientSocket, response);
-    std::cout << "Sent response: " << response << std::endl;
+        // A client that never ends its line would otherwise grow the buffer without bound
+        if (lineTooLong(input)) {
+            logMessage(LOG_WARN, "Line too long from %s, closing", conn.peer);
+            std::string& out = replyBuffer(conn);
+            out += "Line too long (at most ";
+            appendInt(out, MAX_LINE_LENGTH);
+            out += " bytes). Closing connection.\n";
+            removeFdFromReactor(state.reactor, clientSocket);
+            conn.closing = true;
+            flushReplies(state, clientSocket);
+            return nullptr;
+        }
+    } catch (const std::bad_alloc&) {
+        // One client's upload must not take the server (and everyone else) down with it
+        logMessage(LOG_ERROR, "Out of memory serving %s, closing", conn.peer);
+        std::vector<Point>().swap(input.bulkPoints);
+        removeFdFromReactor(state.reactor, clientSocket);
+        conn.closing = true;
+        conn.replies.clear();
+        flushReplies(state, clientSocket);
+        return nullptr;
+    }
+
+    // One send for every reply this read produced
+    flushReplies(state, clientSocket);
     return nullptr;
 }
 
-void* handleNewConnection(int fd) {
+void* handleClientWritable(int clientSocket, void* ctx) {
+    flushReplies(*static_cast<ServerState*>(ctx), clientSocket);
+    return nullptr;
+}
+
+void* handleNewConnection(int fd, void* ctx) {
+    ServerState& state = *static_cast<ServerState*>(ctx);
     struct sockaddr_in clientAddr;
     socklen_t clientLen = sizeof(clientAddr);
     int newSocket = accept(fd, (struct sockaddr*)&clientAddr, &clientLen);
-    if (newSocket < 0) return nullptr;
-
-    std::cout << "New connection from " << inet_ntoa(clientAddr.sin_addr)
-              << ":" << ntohs(clientAddr.sin_port) << std::endl;
+    if (newSocket < 0) {
+        logMessage(LOG_ERROR, "Accept failed: %s", strerror(errno));
+        return nullptr;
+    }
 
-    sendToClient(newSocket, "Commands: Newgraph <n>, <x,y>, CH, Newpoint <x,y>, Removepoint <x,y>, Status");
-    addFdToReactor(globalReactor, newSocket, handleClientData);
-    clientSockets[newSocket] = true;
+    sendToClient(newSocket, "Commands: Newgraph <n>, <x,y>, Loadpoints <n>, CH, Newpoint <x,y>, Removepoint <x,y>, Status");
+    addFdToReactorCtx(state.reactor, newSocket, handleClientData, &state);
+    ClientConnection& conn = state.clientSockets[newSocket];
+    conn.id = state.nextConnectionId++;
+    formatPeer(clientAddr, conn.peer, sizeof(conn.peer));
+    logMessage(LOG_INFO, "New connection from %s", conn.peer);
     return nullptr;
 }
 
-void* handleServerInput(int) {
+void* handleServerInput(int, void* ctx) {
+    ServerState& state = *static_cast<ServerState*>(ctx);
     std::string input;
     std::getline(std::cin, input);
 
     if (input == "exit") {
         std::cout << "Shutting down server..." << std::endl;
-        for (auto& pair : clientSockets) {
+        for (auto& pair : state.clientSockets) {
             close(pair.first);
         }
-        stopReactor(globalReactor);
-        close(serverSocket);
+        // Workers post their results to the reactor, so they must be done
+        // before it is freed. Their replies go nowhere: the clients are closed
+        state.pool->shutdown();
+        stopReactor(state.reactor);
+        close(state.serverSocket);
         exit(0);
     }
     return nullptr;
@@ -242,15 +898,16 @@ void* handleServerInput(int) {
 
 int main() {
     struct sockaddr_in serverAddr;
+    ServerState state;
 
     // Create server socket
-    if ((serverSocket = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
+    if ((state.serverSocket = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
         perror("Socket creation failed");
         exit(EXIT_FAILURE);
     }
 
     int opt = 1;
-    if (setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt)) < 0) {
+    if (setsockopt(state.serverSocket, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt)) < 0) {
         perror("setsockopt failed");
         exit(EXIT_FAILURE);
     }
@@ -259,30 +916,34 @@ int main() {
     serverAddr.sin_addr.s_addr = INADDR_ANY;
     serverAddr.sin_port = htons(PORT);
 
-    if (bind(serverSocket, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
+    if (bind(state.serverSocket, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
         perror("Bind failed");
         exit(EXIT_FAILURE);
     }
 
-    if (listen(serverSocket, MAXCLIENTS) < 0) {
+    if (listen(state.serverSocket, MAXCLIENTS) < 0) {
         perror("Listen failed");
         exit(EXIT_FAILURE);
     }
 
     std::cout << "Convex Hull Server listening on port " << PORT << std::endl;
-    std::cout << "Available commands: Newgraph <n>, <x,y>, CH, Newpoint <x,y>, Removepoint <x,y>, Status or 'exit'" << std::endl;
+    std::cout << "Available commands: Newgraph <n>, <x,y>, Loadpoints <n>, CH, Newpoint <x,y>, Removepoint <x,y>, Status or 'exit'" << std::endl;
+
+    startLogger();
 
     // Start reactor
-    globalReactor = startReactor();
-    addFdToReactor(globalReactor, serverSocket, handleNewConnection);
-    addFdToReactor(globalReactor, STDIN_FILENO, handleServerInput);
+    state.reactor = startReactor();
+    ComputePool pool;
+    state.pool = &pool;
+    addFdToReactorCtx(state.reactor, state.serverSocket, handleNewConnection, &state);
+    addFdToReactorCtx(state.reactor, STDIN_FILENO, handleServerInput, &state);
 
     // Main event loop
     while (true) {
-        if (runReactorOnce(globalReactor) != 0)
+        if (runReactorOnce(state.reactor) != 0)
             break;
     }
 
-    close(serverSocket);
+    close(state.serverSocket);
     return 0;
 }
\ No newline at end of file
@@ -6,10 +6,17 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <map>
+#include <deque>
+#include "compute_pool.hpp"
 
 #define PORT 9034
 #define MAXCLIENTS 10
-#define BUFSIZE 1024
+#define BUFSIZE 65536
+#define PEER_NAME_SIZE 32 // "255.255.255.255:65535"
+#define MAX_LOAD_POINTS (1 << 24)     // Most points one Loadpoints may announce
+#define LOAD_RESERVE_POINTS (1 << 20) // Reserved when a Loadpoints starts
+#define MAX_LINE_LENGTH 65536         // Longest command line or payload point; longer drops the client
+#define MAX_PENDING_OUTPUT (1 << 20)  // Unsent reply bytes past which a client's requests wait unread
 
 // Point structure
 struct Point {
@@ -22,9 +29,47 @@ struct Point {
     bool operator==(const Point& other) const;
 };
 
-extern void* globalReactor;
-extern std::map<int, bool> clientSockets;
-extern int serverSocket;
+// Per-connection input: bytes received but not yet consumed, plus any
+// Loadpoints upload still in progress
+struct ClientInput {
+    std::string buffer;            // Received bytes
+    size_t pos = 0;                // Start of the unconsumed part of buffer
+    long pendingPoints = 0;        // Loadpoints payload points still expected
+    bool bulkInvalid = false;      // Some payload point failed to parse
+    std::vector<Point> bulkPoints; // Payload points parsed so far
+    long bulkTag = -1;             // Request tag of the Loadpoints in progress, -1 if untagged
+};
+
+// Reply slot kept in request order until its response is ready
+struct PendingReply {
+    bool ready = false;
+    std::string response;
+};
+
+// Per-connection state owned by the reactor thread
+struct ClientConnection {
+    unsigned long id = 0;             // Tells apart connections that reuse an fd
+    unsigned long nextSeq = 0;        // Sequence number of the next request
+    std::deque<PendingReply> replies; // Replies held behind a computing CH, oldest first
+    std::string output;               // Replies ready to send, in order; what the socket did not take yet
+    bool writeWaiting = false;        // output is pending and the reactor reports when the socket drains
+    bool readPaused = false;          // Too much output pending; requests are not read until it is sent
+    ClientInput input;                // Received bytes and Loadpoints progress
+    char peer[PEER_NAME_SIZE] = {};   // "ip:port" for log lines
+    bool closing = false;             // Peer stopped sending; close once the held replies are out
+    unsigned long taggedInFlight = 0; // Tagged CH requests still computing
+};
+
+// Per-server state handed to every reactor callback as its context
+struct ServerState {
+    void* reactor = nullptr;
+    ComputePool* pool = nullptr;      // Workers running CH off the reactor thread
+    std::map<int, ClientConnection> clientSockets;
+    unsigned long nextConnectionId = 1;
+    int serverSocket = -1;
+    std::vector<Point> graph; // Graph data structure shared by this server's clients
+    int counter = 0;          // Points still expected after Newgraph
+};
 
 // Function declarations
 double crossProduct(const Point& O, const Point& A, const Point& B);
@@ -33,19 +78,111 @@ std::vector<Point> convexHull(std::vector<Point> points);
 
 double polygonArea(const std::vector<Point>& vertices);
 
-Point parsePoint(const std::string& pointStr);
+// Parses a number at p (after optional whitespace); returns the position after it or nullptr
+const char* parseDouble(const char* p, const char* end, double& value);
+
+// Parses "x,y" into point without allocating; false if malformed
+bool parsePoint(const char* begin, const char* end, Point& point);
+
+bool parsePoint(const std::string& pointStr, Point& point);
+
+// Parses up to pending whitespace-separated "x,y" tokens from [begin, end) into
+// points, decrementing pending per token and setting invalid on a bad one.
+// A token that runs into end is left for the next call. Returns bytes consumed.
+size_t scanPoints(const char* begin, const char* end, long& pending,
+                  std::vector<Point>& points, bool& invalid);
+
+// Appends received bytes to the connection's input
+void appendInput(ClientInput& input, const char* data, size_t len);
+
+// Takes the next complete line off the input; false if none is buffered yet
+bool nextLine(ClientInput& input, std::string& line);
+
+// Whether the unconsumed input is longer than a command line or payload point may be
+bool lineTooLong(const ClientInput& input);
+
+// Starts a Loadpoints upload from its arguments [args, end); appends an error
+// reply (without newline) to out if the count is invalid
+void startBulkLoad(ClientInput& input, const char* args, const char* end, std::string& out);
+
+// Parses buffered payload points; true once all expected points arrived
+bool consumeBulkPoints(ClientInput& input);
+
+// Replaces the graph with the finished Loadpoints payload and appends the reply to out
+void finishBulkLoad(ServerState& state, ClientInput& input, std::string& out);
+
+// Formats "ip:port" of addr into text
+void formatPeer(const struct sockaddr_in& addr, char* text, size_t size);
 
 void sendToClient(int clientSocket, const std::string& message);
 
-std::string processCommand(const std::string& command);
 
-void* handleClientData(int clientSocket);
+// Fast formatting into an output buffer; appendFixed matches printf("%.*f") and
+// appendPoint writes "(x,y)" like std::to_string
+void appendInt(std::string& out, long long value);
+void appendFixed(std::string& out, double value, int decimals);
+void appendPoint(std::string& out, const Point& point);
+
+// Appends the "Convex Hull Area: a" reply for points
+void appendHullArea(std::string& out, std::vector<Point> points);
+
+// A whitespace-separated word of a command line, pointing into the line
+struct Token {
+    const char* begin;
+    const char* end;
+};
+
+// Takes the next token at or after p and advances p past it; empty at the end
+Token nextToken(const char*& p, const char* end);
+
+// Parses a whole token as an integer; false if it is not one
+bool parseInteger(const Token& token, long& value);
+
+// Runs one command and appends its reply to out; [args, end) is the rest of the line
+typedef void (*CommandHandler)(ServerState& state, ClientInput& input, const char* args, const char* end, std::string& out);
+
+struct CommandEntry {
+    const char* name;
+    size_t length;
+    CommandHandler handler;
+};
+
+// Finds a command word in the dispatch table; nullptr if unknown
+const CommandEntry* findCommand(const char* word, size_t length);
+
+// Runs one command line from the connection with input and appends the reply line to out
+void processCommand(ServerState& state, ClientInput& input, const std::string& command, std::string& out);
+
+// Buffer for the client's next reply: its output, or a queue slot behind a computing CH
+std::string& replyBuffer(ClientConnection& conn);
+
+// Request tags: a command sent as "#<id> <command>" is answered with "#<id> <reply>"
+// as soon as its reply is ready, without waiting for earlier requests
+
+// Strips a leading "#<id> " off command and sets tag to id (-1 if untagged); false if malformed
+bool takeRequestTag(std::string& command, long& tag);
+
+// Appends the "#<id> " prefix of a tagged reply
+void appendTag(std::string& out, long tag);
+
+// Buffer for a reply to a request with the given tag; tagged replies skip the queue
+std::string& replyTo(ClientConnection& conn, long tag);
+
+// Moves the ready replies at the front of the client's queue to its output and
+// sends what the socket takes; closes a closing connection once all is out
+void flushReplies(ServerState& state, int clientSocket);
+
+// Hands CH on a snapshot of the graph to the compute pool. An untagged reply keeps
+// its place in order; a tagged one (tag >= 0) is sent whenever the hull is done
+void offloadConvexHull(ServerState& state, int clientSocket, long tag);
+
+void* handleClientData(int clientSocket, void* ctx);
 
-void* handleNewConnection(int fd);
+// Sends more of the client's pending output once its socket has room
+void* handleClientWritable(int clientSocket, void* ctx);
 
-void* handleServerInput(int fd);
+void* handleNewConnection(int fd, void* ctx);
 
-// Global variable declaration
-extern std::vector<Point> globalGraph;
+void* handleServerInput(int fd, void* ctx);
 
 #endif // CONVEX_HULL_HPP
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "logger.hpp"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <ctime>
+#include <unistd.h>
+
+// One message as the producer left it; the flusher does the text layout
+struct LogRecord {
+    std::atomic<uint64_t> sequence; // Ring position this slot is ready for
+    uint64_t timestampNs;           // CLOCK_REALTIME
+    uint32_t threadId;              // Small per-thread number, not the OS tid
+    uint8_t level;
+    uint16_t length;
+    char text[LOG_TEXT_SIZE];
+};
+
+static LogRecord logRing[LOG_RING_SIZE];
+static std::atomic<uint64_t> enqueuePos{0};
+static uint64_t dequeuePos = 0; // Only the flusher thread touches it
+
+static std::atomic<int> minLevel{LOG_INFO};
+static std::atomic<bool> loggerRunning{false};
+static std::atomic<uint64_t> droppedRecords{0};
+static std::atomic<uint32_t> nextThreadId{1};
+static std::thread flusherThread;
+
+static const char* levelNames[] = {"DEBUG", "INFO ", "WARN ", "ERROR"};
+
+static uint32_t currentThreadId() {
+    static thread_local uint32_t id = nextThreadId.fetch_add(1);
+    return id;
+}
+
+bool logEnabled(LogLevel level) {
+    return loggerRunning.load(std::memory_order_relaxed) &&
+           level >= minLevel.load(std::memory_order_relaxed);
+}
+
+void logMessage(LogLevel level, const char* format, ...) {
+    if (!logEnabled(level)) return;
+
+    // Claim a slot (bounded MPMC ring with per-slot sequence numbers)
+    uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+    LogRecord* record;
+    while (true) {
+        record = &logRing[pos & (LOG_RING_SIZE - 1)];
+        uint64_t seq = record->sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // The flusher is a full ring behind
+            droppedRecords.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    record->timestampNs = static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+    record->threadId = currentThreadId();
+    record->level = static_cast<uint8_t>(level);
+
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(record->text, LOG_TEXT_SIZE, format, args);
+    va_end(args);
+    if (n < 0) n = 0;
+    record->length = static_cast<uint16_t>(n < LOG_TEXT_SIZE ? n : LOG_TEXT_SIZE - 1);
+
+    record->sequence.store(pos + 1, std::memory_order_release);
+}
+
+static void writeAll(const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(STDOUT_FILENO, data, len);
+        if (n <= 0) return;
+        data += n;
+        len -= n;
+    }
+}
+
+// Turns every ready record into a line; returns how many there were
+static size_t drainRing(char* batch, size_t batchSize) {
+    size_t used = 0;
+    size_t drained = 0;
+
+    uint64_t dropped = droppedRecords.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        used += snprintf(batch, batchSize, "[logger] dropped %llu messages\n",
+                         static_cast<unsigned long long>(dropped));
+    }
+
+    while (true) {
+        LogRecord& record = logRing[dequeuePos & (LOG_RING_SIZE - 1)];
+        if (record.sequence.load(std::memory_order_acquire) != dequeuePos + 1) break;
+
+        // Leave room for the prefix and the record's text
+        if (batchSize - used < LOG_TEXT_SIZE + 64) {
+            writeAll(batch, used);
+            used = 0;
+        }
+
+        time_t seconds = static_cast<time_t>(record.timestampNs / 1000000000ULL);
+        unsigned micros = static_cast<unsigned>(record.timestampNs % 1000000000ULL / 1000);
+        struct tm local;
+        localtime_r(&seconds, &local);
+        used += snprintf(batch + used, batchSize - used, "%02d:%02d:%02d.%06u %s [t%u] ",
+                         local.tm_hour, local.tm_min, local.tm_sec, micros,
+                         levelNames[record.level], record.threadId);
+        memcpy(batch + used, record.text, record.length);
+        used += record.length;
+        batch[used++] = '\n';
+
+        record.sequence.store(dequeuePos + LOG_RING_SIZE, std::memory_order_release);
+        dequeuePos++;
+        drained++;
+    }
+
+    writeAll(batch, used);
+    return drained;
+}
+
+static void flusherLoop() {
+    static char batch[1 << 16];
+    while (loggerRunning.load(std::memory_order_acquire)) {
+        if (drainRing(batch, sizeof(batch)) == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    drainRing(batch, sizeof(batch));
+}
+
+void startLogger() {
+    if (loggerRunning.load()) return;
+
+    const char* level = getenv("CH_LOG_LEVEL");
+    if (level) {
+        if (strcmp(level, "debug") == 0) minLevel = LOG_DEBUG;
+        else if (strcmp(level, "info") == 0) minLevel = LOG_INFO;
+        else if (strcmp(level, "warn") == 0) minLevel = LOG_WARN;
+        else if (strcmp(level, "error") == 0) minLevel = LOG_ERROR;
+    }
+
+    for (uint64_t i = 0; i < LOG_RING_SIZE; i++) {
+        logRing[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueuePos = 0;
+    dequeuePos = 0;
+
+    loggerRunning = true;
+    flusherThread = std::thread(flusherLoop);
+
+    // exit() must not destroy a joinable thread, and should not lose queued lines
+    static bool registered = false;
+    if (!registered) {
+        registered = true;
+        atexit(stopLogger);
+    }
+}
+
+void stopLogger() {
+    if (!loggerRunning.exchange(false)) return;
+    flusherThread.join();
+}
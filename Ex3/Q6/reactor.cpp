@@ -4,17 +4,40 @@
 #include <unistd.h>
 #include <cstring>
 #include <iostream>
+#include <atomic>
+#include <cerrno>
+#include <sys/eventfd.h>
 
 #define MAX_FD 1024
 
+// Posted task, linked into the reactor's multi-producer queue
+struct reactorTaskNode {
+    reactorTask task;
+    void* arg;
+    reactorTaskNode* next;
+};
+
 struct reactorStruct {
     std::unordered_set<int> fds; // Set of active file descriptors
     reactorFunc funcs[MAX_FD] = {nullptr}; // Callback functions per fd
-    bool running = false; // Whether the loop is running
+    reactorCtxFunc ctxFuncs[MAX_FD] = {nullptr}; // Context-carrying callbacks per fd
+    void* ctxs[MAX_FD] = {nullptr}; // Context handed to ctxFuncs
+    std::unordered_set<int> writeFds; // File descriptors waited on for writing
+    reactorCtxFunc writeFuncs[MAX_FD] = {nullptr}; // Callbacks per writable fd
+    void* writeCtxs[MAX_FD] = {nullptr}; // Context handed to writeFuncs
+    std::atomic<bool> running{false}; // Whether the loop is running
+    std::atomic<reactorTaskNode*> tasks{nullptr}; // Tasks posted from other threads (newest first)
+    int wakeFd = -1; // eventfd signalled by postToReactor
 };
 
 void* startReactor() {
     reactorStruct* r = new reactorStruct;
+    r->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (r->wakeFd < 0) {
+        perror("eventfd");
+        delete r;
+        return nullptr;
+    }
     r->running = true;  // Start running immediately
     return static_cast<void*>(r);
 }
@@ -24,6 +47,18 @@ int addFdToReactor(void* reactor, int fd, reactorFunc func) {
     auto r = static_cast<reactorStruct*>(reactor);
     r->fds.insert(fd);
     r->funcs[fd] = func;
+    r->ctxFuncs[fd] = nullptr;
+    r->ctxs[fd] = nullptr;
+    return 0;
+}
+
+int addFdToReactorCtx(void* reactor, int fd, reactorCtxFunc func, void* ctx) {
+    if (!reactor || fd < 0 || fd >= MAX_FD) return -1;
+    auto r = static_cast<reactorStruct*>(reactor);
+    r->fds.insert(fd);
+    r->funcs[fd] = nullptr;
+    r->ctxFuncs[fd] = func;
+    r->ctxs[fd] = ctx;
     return 0;
 }
 
@@ -32,6 +67,26 @@ int removeFdFromReactor(void* reactor, int fd) {
     auto r = static_cast<reactorStruct*>(reactor);
     r->fds.erase(fd);
     r->funcs[fd] = nullptr;
+    r->ctxFuncs[fd] = nullptr;
+    r->ctxs[fd] = nullptr;
+    return 0;
+}
+
+int addWriteFdToReactorCtx(void* reactor, int fd, reactorCtxFunc func, void* ctx) {
+    if (!reactor || fd < 0 || fd >= MAX_FD) return -1;
+    auto r = static_cast<reactorStruct*>(reactor);
+    r->writeFds.insert(fd);
+    r->writeFuncs[fd] = func;
+    r->writeCtxs[fd] = ctx;
+    return 0;
+}
+
+int removeWriteFdFromReactor(void* reactor, int fd) {
+    if (!reactor || fd < 0 || fd >= MAX_FD) return -1;
+    auto r = static_cast<reactorStruct*>(reactor);
+    r->writeFds.erase(fd);
+    r->writeFuncs[fd] = nullptr;
+    r->writeCtxs[fd] = nullptr;
     return 0;
 }
 
@@ -39,10 +94,59 @@ int stopReactor(void* reactor) {
     if (!reactor) return -1;
     auto r = static_cast<reactorStruct*>(reactor);
     r->running = false;
+
+    // Drop tasks that never got to run
+    reactorTaskNode* node = r->tasks.exchange(nullptr);
+    while (node) {
+        reactorTaskNode* next = node->next;
+        delete node;
+        node = next;
+    }
+    close(r->wakeFd);
     delete r;
     return 0;
 }
 
+int postToReactor(void* reactor, reactorTask task, void* arg) {
+    if (!reactor || !task) return -1;
+    auto r = static_cast<reactorStruct*>(reactor);
+    if (!r->running) return -1;
+
+    // Lock-free push; the reactor thread takes the whole list at once
+    reactorTaskNode* node = new reactorTaskNode{task, arg, r->tasks.load(std::memory_order_relaxed)};
+    while (!r->tasks.compare_exchange_weak(node->next, node,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+    }
+
+    uint64_t one = 1;
+    if (write(r->wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("write (eventfd)");
+    }
+    return 0;
+}
+
+// Run all tasks posted so far, oldest first
+static void runPostedTasks(reactorStruct* r) {
+    reactorTaskNode* node = r->tasks.exchange(nullptr, std::memory_order_acquire);
+
+    // The queue is a stack, reverse it to keep posting order
+    reactorTaskNode* ordered = nullptr;
+    while (node) {
+        reactorTaskNode* next = node->next;
+        node->next = ordered;
+        ordered = node;
+        node = next;
+    }
+
+    while (ordered) {
+        reactorTaskNode* next = ordered->next;
+        ordered->task(ordered->arg);
+        delete ordered;
+        ordered = next;
+    }
+}
+
 // Run one iteration of the reactor event loop
 int runReactorOnce(void* reactor) {
     if (!reactor) return -1;
@@ -50,34 +154,58 @@ int runReactorOnce(void* reactor) {
     
     if (!r->running) return -1;
     
-    fd_set readfds;
+    fd_set readfds, writefds;
     struct timeval tv;
     FD_ZERO(&readfds);
-    int maxfd = 0;
+    FD_ZERO(&writefds);
+    FD_SET(r->wakeFd, &readfds);
+    int maxfd = r->wakeFd;
 
     for (int fd : r->fds) {
         FD_SET(fd, &readfds);
         if (fd > maxfd) maxfd = fd;
     }
+    for (int fd : r->writeFds) {
+        FD_SET(fd, &writefds);
+        if (fd > maxfd) maxfd = fd;
+    }
 
     tv.tv_sec = 0;  // Don't block for too long
     tv.tv_usec = 100000;  // 100ms timeout
 
-    int ready = select(maxfd + 1, &readfds, nullptr, nullptr, &tv);
+    int ready = select(maxfd + 1, &readfds, &writefds, nullptr, &tv);
     if (ready < 0) {
         if (errno == EINTR) return 0;
         perror("select");
         return -1;
     }
 
+    if (FD_ISSET(r->wakeFd, &readfds)) {
+        uint64_t pending;
+        if (read(r->wakeFd, &pending, sizeof(pending)) < 0 && errno != EAGAIN) {
+            perror("read (eventfd)");
+        }
+    }
+    runPostedTasks(r);
+
     auto fds = r->fds;  // Copy to avoid iterator invalidation
     for (int fd : fds) {
         if (FD_ISSET(fd, &readfds)) {
             if (r->funcs[fd]) {
                 r->funcs[fd](fd);
+            } else if (r->ctxFuncs[fd]) {
+                r->ctxFuncs[fd](fd, r->ctxs[fd]);
             }
         }
     }
 
+    // A read callback may have stopped the write callback meanwhile
+    auto writeFds = r->writeFds;
+    for (int fd : writeFds) {
+        if (FD_ISSET(fd, &writefds) && r->writeFuncs[fd]) {
+            r->writeFuncs[fd](fd, r->writeCtxs[fd]);
+        }
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,261 @@
+// Tests of the reactor server over its socket; run from Q6 with port 9034 free.
+// Each test starts ./convex_hull_server with its console on a pipe.
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#define PORT 9034
+#define START_TIMEOUT_MS 5000
+#define REPLY_TIMEOUT_MS 10000
+#define HULL_POINTS 2000000 // Enough for a CH to still be computing a little later
+#define STALLED_REQUESTS 200000 // Replies far beyond the socket buffers and MAX_PENDING_OUTPUT
+
+struct TestServer {
+    pid_t pid;
+    int console; // The server's stdin
+};
+
+static int connectToServer() {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in serverAddr;
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(PORT);
+    inet_pton(AF_INET, "127.0.0.1", &serverAddr.sin_addr);
+    if (connect(sock, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static TestServer startServer() {
+    TestServer server;
+    int fds[2];
+    int piped = pipe(fds);
+    assert(piped == 0);
+    server.pid = fork();
+    if (server.pid == 0) {
+        prctl(PR_SET_PDEATHSIG, SIGKILL); // A failed assert must not leave the port taken
+        dup2(fds[0], STDIN_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        execl("./convex_hull_server", "convex_hull_server", static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    close(fds[0]);
+    server.console = fds[1];
+
+    for (int waited = 0; waited < START_TIMEOUT_MS; waited += 20) {
+        int sock = connectToServer();
+        if (sock >= 0) {
+            close(sock);
+            return server;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    std::cerr << "Server did not start listening on port " << PORT << std::endl;
+    kill(server.pid, SIGKILL);
+    exit(1);
+}
+
+// Whether the server is still running
+static bool serverAlive(const TestServer& server) {
+    int status;
+    return waitpid(server.pid, &status, WNOHANG) == 0;
+}
+
+// Stops the server with the console's exit command; returns its exit status
+static int stopServer(const TestServer& server) {
+    ssize_t written = write(server.console, "exit\n", 5);
+    assert(written == 5);
+    int status = 0;
+    for (int waited = 0; waited < START_TIMEOUT_MS; waited += 20) {
+        if (waitpid(server.pid, &status, WNOHANG) == server.pid) {
+            close(server.console);
+            return status;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    kill(server.pid, SIGKILL);
+    waitpid(server.pid, &status, 0);
+    close(server.console);
+    return status;
+}
+
+static void sendAll(int sock, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(sock, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        assert(n > 0);
+        sent += n;
+    }
+}
+
+// Next reply line without its newline; false on timeout or disconnect
+static bool readLine(int sock, std::string& line) {
+    line.clear();
+    while (true) {
+        struct pollfd pfd = {sock, POLLIN, 0};
+        if (poll(&pfd, 1, REPLY_TIMEOUT_MS) <= 0) return false;
+        char c;
+        if (recv(sock, &c, 1, 0) != 1) return false;
+        if (c == '\n') return true;
+        line += c;
+    }
+}
+
+// Connects and replaces the graph with HULL_POINTS points
+static int connectWithLargeGraph() {
+    int sock = connectToServer();
+    assert(sock >= 0);
+    std::string line;
+    bool banner = readLine(sock, line);
+    assert(banner);
+
+    std::string load = "Loadpoints " + std::to_string(HULL_POINTS) + "\n";
+    char point[48];
+    for (long i = 0; i < HULL_POINTS; i++) {
+        snprintf(point, sizeof(point), "%ld,%ld\n", i % 9973, (i * 7919) % 10007);
+        load += point;
+    }
+    sendAll(sock, load);
+    bool loaded = readLine(sock, line);
+    assert(loaded && line.compare(0, 17, "Graph loaded with") == 0);
+    return sock;
+}
+
+void testResetWhileHullComputing() {
+    std::cout << "\n=== Testing a reset while CH is computing ===" << std::endl;
+    TestServer server = startServer();
+    int sock = connectWithLargeGraph();
+
+    // The untagged CH is queued first, so it finishes while tagged ones are still in flight
+    std::string requests = "CH\n";
+    unsigned workers = std::thread::hardware_concurrency();
+    for (unsigned i = 0; i < 2 * workers + 2; i++) requests += "#" + std::to_string(i) + " CH\n";
+    sendAll(sock, requests);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // Abortive close: the server's read fails with ECONNRESET
+    struct linger reset = {1, 0};
+    setsockopt(sock, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+    close(sock);
+
+    // Another client is still served once every CH has finished
+    int other = connectToServer();
+    assert(other >= 0);
+    std::string line;
+    bool banner = readLine(other, line);
+    assert(banner);
+    sendAll(other, "CH\n");
+    bool answered = readLine(other, line);
+    assert(answered && line.compare(0, 17, "Convex Hull Area:") == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    assert(serverAlive(server));
+    std::cout << "✓ Server survived the results of a reset connection" << std::endl;
+
+    close(other);
+    stopServer(server);
+}
+
+void testExitWhileHullComputing() {
+    std::cout << "\n=== Testing exit while CH is computing ===" << std::endl;
+    TestServer server = startServer();
+    int sock = connectWithLargeGraph();
+
+    // Every worker busy, with more queued, when the console says exit
+    std::string requests;
+    unsigned workers = std::thread::hardware_concurrency();
+    for (unsigned i = 0; i < workers + 2; i++) requests += "#" + std::to_string(i) + " CH\n";
+    sendAll(sock, requests);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    int status = stopServer(server);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    std::cout << "✓ Server exited cleanly with hulls in flight" << std::endl;
+    close(sock);
+}
+
+void testStalledReader() {
+    std::cout << "\n=== Testing a client that does not read its replies ===" << std::endl;
+    TestServer server = startServer();
+
+    // A small receive buffer, so the server's sends to it stall early
+    int stalled = socket(AF_INET, SOCK_STREAM, 0);
+    int small = 4096;
+    setsockopt(stalled, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+    struct sockaddr_in serverAddr;
+    memset(&serverAddr, 0, sizeof(serverAddr));
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(PORT);
+    inet_pton(AF_INET, "127.0.0.1", &serverAddr.sin_addr);
+    int connected = connect(stalled, (struct sockaddr*)&serverAddr, sizeof(serverAddr));
+    assert(connected == 0);
+
+    // Sent from a thread: once the server stops reading it, this blocks too
+    std::string requests;
+    for (int i = 0; i < STALLED_REQUESTS; i++) requests += "Status\n";
+    std::thread sender([stalled, &requests]() { sendAll(stalled, requests); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    int other = connectToServer();
+    assert(other >= 0);
+    std::string line;
+    bool got = readLine(other, line);
+    assert(got);
+    sendAll(other, "Status\n");
+    got = readLine(other, line);
+    assert(got && line == "Current graph has 0 points");
+    std::cout << "✓ Other clients are served while one stops reading" << std::endl;
+
+    // Once it reads again, every reply arrives, in one piece
+    got = readLine(stalled, line);
+    assert(got);
+    const std::string reply = "Current graph has 0 points\n";
+    std::string replies;
+    char buffer[65536];
+    while (replies.size() < reply.size() * STALLED_REQUESTS) {
+        struct pollfd pfd = {stalled, POLLIN, 0};
+        int ready = poll(&pfd, 1, REPLY_TIMEOUT_MS);
+        assert(ready == 1);
+        ssize_t n = recv(stalled, buffer, sizeof(buffer), 0);
+        assert(n > 0);
+        replies.append(buffer, n);
+    }
+    for (size_t at = 0; at < replies.size(); at += reply.size()) {
+        assert(replies.compare(at, reply.size(), reply) == 0);
+    }
+    sender.join();
+    std::cout << "✓ The stalled client gets all its replies" << std::endl;
+
+    close(other);
+    close(stalled);
+    int status = stopServer(server);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+int main() {
+    std::cout << "Starting server tests..." << std::endl;
+    testResetWhileHullComputing();
+    testExitWhileHullComputing();
+    testStalledReader();
+    std::cout << "\n=== All server tests completed ===" << std::endl;
+    return 0;
+}
@@ -5,11 +5,108 @@
 #include <unistd.h>
 #include <cstring>
 #include <fcntl.h>
+#include <cerrno>
+#include <chrono>
 
 #define PORT 9034
 #define BUFSIZE 1024
+#define PIPELINE_CHUNK 65536    // Bytes read from the command source at a time
+#define PIPELINE_WINDOW 1048576 // Unsent command bytes held before reading more
+
+// Pipelined mode: streams every command from inputFd to the server without
+// waiting for replies, while printing the replies as they arrive. Once all
+// commands are sent the write side is shut down, and the server closes the
+// connection after answering the last one, in order.
+int runPipelined(int clientSocket, int inputFd) {
+    std::string pending; // Commands read but not yet sent
+    size_t sent = 0;     // Part of pending already sent
+    bool inputDone = false;
+    bool shutdownSent = false;
+    long commands = 0, replies = 0;
+    char buffer[PIPELINE_CHUNK];
+
+    // Never block on the socket: replies must be drained while commands are sent
+    fcntl(clientSocket, F_SETFL, fcntl(clientSocket, F_GETFL, 0) | O_NONBLOCK);
+    auto start = std::chrono::steady_clock::now();
+
+    while (true) {
+        fd_set readfds, writefds;
+        FD_ZERO(&readfds);
+        FD_ZERO(&writefds);
+        FD_SET(clientSocket, &readfds);
+        int maxfd = clientSocket;
+        if (!inputDone && pending.size() - sent < PIPELINE_WINDOW) {
+            FD_SET(inputFd, &readfds);
+            if (inputFd > maxfd) maxfd = inputFd;
+        }
+        if (sent < pending.size()) FD_SET(clientSocket, &writefds);
+
+        if (select(maxfd + 1, &readfds, &writefds, NULL, NULL) < 0) {
+            if (errno == EINTR) continue;
+            perror("select error");
+            return -1;
+        }
+
+        // Replies: print them unchanged, counting lines
+        if (FD_ISSET(clientSocket, &readfds)) {
+            ssize_t n = read(clientSocket, buffer, sizeof(buffer));
+            if (n == 0) break; // Server answered everything and closed
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("read error");
+                return -1;
+            }
+            if (n > 0) {
+                for (ssize_t i = 0; i < n; i++) replies += buffer[i] == '\n';
+                std::cout.write(buffer, n);
+            }
+        }
+
+        // More commands from the source
+        if (!inputDone && FD_ISSET(inputFd, &readfds)) {
+            ssize_t n = read(inputFd, buffer, sizeof(buffer));
+            if (n <= 0) {
+                inputDone = true;
+            } else {
+                if (sent > pending.size() / 2) {
+                    // Drop the sent prefix so pending stays within the window
+                    pending.erase(0, sent);
+                    sent = 0;
+                }
+                pending.append(buffer, n);
+                for (ssize_t i = 0; i < n; i++) commands += buffer[i] == '\n';
+            }
+        }
+
+        // As many commands as the socket takes in one go
+        if (sent < pending.size()) {
+            ssize_t n = send(clientSocket, pending.data() + sent, pending.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("send error");
+                return -1;
+            }
+            if (n > 0) sent += n;
+        }
+
+        if (inputDone && sent == pending.size() && !shutdownSent) {
+            shutdown(clientSocket, SHUT_WR);
+            shutdownSent = true;
+        }
+    }
+
+    std::cout << std::flush;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Pipelined " << commands << " command lines, received " << replies
+              << " reply lines in " << seconds << "s" << std::endl;
+    return shutdownSent ? 0 : -1;
+}
+
+int main(int argc, char* argv[]) {
+    bool pipelined = argc > 1 && strcmp(argv[1], "-p") == 0;
+    if (argc > 1 && !pipelined) {
+        std::cerr << "Usage: " << argv[0] << " [-p [command-file]]" << std::endl;
+        return -1;
+    }
 
-int main() {
     int clientSocket;
     struct sockaddr_in serverAddr;
     fd_set readfds;
@@ -38,6 +135,18 @@ int main() {
         std::cerr << "Connection failed" << std::endl;
         return -1;
     }
+
+    if (pipelined) {
+        // Commands come from the file, or from stdin when none is given
+        int inputFd = STDIN_FILENO;
+        if (argc > 2 && (inputFd = open(argv[2], O_RDONLY)) < 0) {
+            perror(argv[2]);
+            return -1;
+        }
+        int result = runPipelined(clientSocket, inputFd);
+        close(clientSocket);
+        return result;
+    }
     
     // Set stdin to non-blocking mode
     int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
@@ -9,7 +9,11 @@
 
 #define PORT 9034
 #define MAXCLIENTS 10
-#define BUFSIZE 1024
+#define BUFSIZE 65536
+#define PEER_NAME_SIZE 32 // "255.255.255.255:65535"
+#define MAX_LOAD_POINTS (1 << 24)     // Most points one Loadpoints may announce
+#define LOAD_RESERVE_POINTS (1 << 20) // Reserved when a Loadpoints starts
+#define MAX_LINE_LENGTH 65536         // Longest command line or payload point; longer drops the client
 
 // Point structure
 struct Point {
@@ -22,6 +26,17 @@ struct Point {
     bool operator==(const Point& other) const;
 };
 
+// Per-connection buffers: bytes received but not yet consumed, replies not
+// yet sent, plus any Loadpoints upload still in progress
+struct ClientInput {
+    std::string buffer;            // Received bytes
+    size_t pos = 0;                // Start of the unconsumed part of buffer
+    std::string output;            // Replies formatted but not yet sent
+    long pendingPoints = 0;        // Loadpoints payload points still expected
+    bool bulkInvalid = false;      // Some payload point failed to parse
+    std::vector<Point> bulkPoints; // Payload points parsed so far
+};
+
 // Function declarations
 double crossProduct(const Point& O, const Point& A, const Point& B);
 
@@ -29,11 +44,83 @@ std::vector<Point> convexHull(std::vector<Point> points);
 
 double polygonArea(const std::vector<Point>& vertices);
 
-Point parsePoint(const std::string& pointStr);
+// Parses a number at p (after optional whitespace); returns the position after it or nullptr
+const char* parseDouble(const char* p, const char* end, double& value);
+
+// Parses "x,y" into point without allocating; false if malformed
+bool parsePoint(const char* begin, const char* end, Point& point);
+
+bool parsePoint(const std::string& pointStr, Point& point);
+
+// Parses up to pending whitespace-separated "x,y" tokens from [begin, end) into
+// points, decrementing pending per token and setting invalid on a bad one.
+// A token that runs into end is left for the next call. Returns bytes consumed.
+size_t scanPoints(const char* begin, const char* end, long& pending,
+                  std::vector<Point>& points, bool& invalid);
+
+// Appends received bytes to the connection's input
+void appendInput(ClientInput& input, const char* data, size_t len);
+
+// Takes the next complete line off the input; false if none is buffered yet
+bool nextLine(ClientInput& input, std::string& line);
+
+// Whether the unconsumed input is longer than a command line or payload point may be
+bool lineTooLong(const ClientInput& input);
+
+// Starts a Loadpoints upload from its arguments [args, end); appends an error
+// reply (without newline) to out if the count is invalid
+void startBulkLoad(ClientInput& input, const char* args, const char* end, std::string& out);
+
+// Parses buffered payload points; true once all expected points arrived
+bool consumeBulkPoints(ClientInput& input);
+
+// Replaces the graph with the finished Loadpoints payload and appends the reply to out
+void finishBulkLoad(ClientInput& input, std::string& out);
+
+// Appends a read's bytes and runs every complete command, leaving the replies
+// in input.output; false if the connection has to be dropped
+bool serveInput(ClientInput& input, const char* data, size_t len, const char* peer);
+
+// Formats "ip:port" of addr into text
+void formatPeer(const struct sockaddr_in& addr, char* text, size_t size);
 
 void sendToClient(int clientSocket, const std::string& message);
 
-std::string processCommand(const std::string& command);
+// Sends the buffered replies and empties output
+void flushOutput(int clientSocket, std::string& output);
+
+// Fast formatting into an output buffer; appendFixed matches printf("%.*f") and
+// appendPoint writes "(x,y)" like std::to_string
+void appendInt(std::string& out, long long value);
+void appendFixed(std::string& out, double value, int decimals);
+void appendPoint(std::string& out, const Point& point);
+
+// A whitespace-separated word of a command line, pointing into the line
+struct Token {
+    const char* begin;
+    const char* end;
+};
+
+// Takes the next token at or after p and advances p past it; empty at the end
+Token nextToken(const char*& p, const char* end);
+
+// Parses a whole token as an integer; false if it is not one
+bool parseInteger(const Token& token, long& value);
+
+// Runs one command and appends its reply to out; [args, end) is the rest of the line
+typedef void (*CommandHandler)(ClientInput& input, const char* args, const char* end, std::string& out);
+
+struct CommandEntry {
+    const char* name;
+    size_t length;
+    CommandHandler handler;
+};
+
+// Finds a command word in the dispatch table; nullptr if unknown
+const CommandEntry* findCommand(const char* word, size_t length);
+
+// Runs one command line from the connection with input and appends the reply line to out
+void processCommand(ClientInput& input, const std::string& command, std::string& out);
 
 void handleClient(int clientSocket, struct sockaddr_in clientAddr);
 
@@ -10,6 +10,8 @@
 #include <fcntl.h>
 #include <thread>
 #include <atomic>
+#include <string>
+#include <vector>
 
 // Test callback function
 void* testCallback(int fd) {
@@ -79,6 +81,140 @@ void testErrorConditions() {
     std::cout << "✓ Invalid fd tests passed" << std::endl;
 }
 
+// Context callback: counts bytes read into the context it was registered with
+void* countingCallback(int fd, void* ctx) {
+    char buffer[256];
+    int bytesRead = read(fd, buffer, sizeof(buffer));
+    if (bytesRead > 0) {
+        *static_cast<int*>(ctx) += bytesRead;
+    }
+    return nullptr;
+}
+
+// Test that two reactors with context callbacks keep independent state
+void testContextCallbacks() {
+    std::cout << "\n=== Testing Context Callbacks ===" << std::endl;
+
+    void* reactorA = startReactor();
+    void* reactorB = startReactor();
+    assert(reactorA != nullptr && reactorB != nullptr);
+
+    int pipeA[2], pipeB[2];
+    if (pipe(pipeA) == -1 || pipe(pipeB) == -1) {
+        perror("pipe");
+        return;
+    }
+
+    int countA = 0, countB = 0;
+    assert(addFdToReactorCtx(reactorA, pipeA[0], countingCallback, &countA) == 0);
+    assert(addFdToReactorCtx(reactorB, pipeB[0], countingCallback, &countB) == 0);
+    assert(addFdToReactorCtx(nullptr, pipeA[0], countingCallback, &countA) == -1);
+    assert(addFdToReactorCtx(reactorA, -1, countingCallback, &countA) == -1);
+    std::cout << "✓ addFdToReactorCtx test passed" << std::endl;
+
+    assert(write(pipeA[1], "abc", 3) == 3);
+    assert(write(pipeB[1], "hello", 5) == 5);
+
+    for (int i = 0; i < 3; i++) {
+        runReactorOnce(reactorA);
+        runReactorOnce(reactorB);
+    }
+    assert(countA == 3);
+    assert(countB == 5);
+    std::cout << "✓ Independent reactor contexts test passed" << std::endl;
+
+    assert(removeFdFromReactor(reactorA, pipeA[0]) == 0);
+    assert(removeFdFromReactor(reactorB, pipeB[0]) == 0);
+    stopReactor(reactorA);
+    stopReactor(reactorB);
+
+    close(pipeA[0]);
+    close(pipeA[1]);
+    close(pipeB[0]);
+    close(pipeB[1]);
+}
+
+// Posted task argument: which producer posted it and in what order
+struct postedTask {
+    int producer;
+    int seq;
+};
+
+struct postTestState {
+    pthread_t reactorThread;
+    int lastSeq[4];
+    int executed;
+    bool ordered;
+    bool onReactorThread;
+};
+
+postTestState postState;
+
+void recordPostedTask(void* arg) {
+    postedTask* task = static_cast<postedTask*>(arg);
+    if (!pthread_equal(pthread_self(), postState.reactorThread)) postState.onReactorThread = false;
+    if (task->seq != postState.lastSeq[task->producer] + 1) postState.ordered = false;
+    postState.lastSeq[task->producer] = task->seq;
+    postState.executed++;
+    delete task;
+}
+
+// Test tasks posted from several threads run on the reactor thread in posting order
+void testPostToReactor() {
+    std::cout << "\n=== Testing postToReactor ===" << std::endl;
+
+    assert(postToReactor(nullptr, recordPostedTask, nullptr) == -1);
+
+    void* reactor = startReactor();
+    assert(reactor != nullptr);
+    assert(postToReactor(reactor, nullptr, nullptr) == -1);
+
+    const int producers = 4;
+    int perProducer = 1000;
+    postState.reactorThread = pthread_self();
+    for (int i = 0; i < producers; i++) postState.lastSeq[i] = -1;
+    postState.executed = 0;
+    postState.ordered = true;
+    postState.onReactorThread = true;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([reactor, p, perProducer]() {
+            for (int i = 0; i < perProducer; i++) {
+                assert(postToReactor(reactor, recordPostedTask, new postedTask{p, i}) == 0);
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    while (postState.executed < producers * perProducer &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+        runReactorOnce(reactor);
+    }
+    for (auto& t : threads) t.join();
+    runReactorOnce(reactor);
+
+    assert(postState.executed == producers * perProducer);
+    assert(postState.ordered);
+    assert(postState.onReactorThread);
+    std::cout << "✓ " << postState.executed << " posted tasks ran in order on the reactor thread" << std::endl;
+
+    // A post from another thread must wake a reactor blocked in select
+    std::thread late([reactor, perProducer]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        postToReactor(reactor, recordPostedTask, new postedTask{0, perProducer});
+    });
+    start = std::chrono::steady_clock::now();
+    while (postState.executed == producers * perProducer) {
+        runReactorOnce(reactor);
+    }
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    late.join();
+    std::cout << "✓ Wakeup after post took " << waited.count() << " ms" << std::endl;
+
+    stopReactor(reactor);
+}
+
 // Add this new callback function specifically for server socket
 void* serverSocketCallback(int fd) {
     std::cout << "Server callback triggered for fd: " << fd << std::endl;
@@ -235,14 +371,92 @@ void testProactor() {
     std::cout << "✓ Proactor test completed" << std::endl;
 }
 
+// Proactor context callback: replies with the tag of the proactor that accepted
+void* taggedClientHandler(int clientfd, void* ctx) {
+    const char* tag = static_cast<const char*>(ctx);
+    char buffer[256];
+    if (read(clientfd, buffer, sizeof(buffer)) > 0) {
+        write(clientfd, tag, strlen(tag));
+    }
+    close(clientfd);
+    return nullptr;
+}
+
+// Connect to a local port, send a byte and return the reply
+std::string requestReply(int port) {
+    int clientSocket = socket(AF_INET, SOCK_STREAM, 0);
+    assert(clientSocket >= 0);
+
+    struct sockaddr_in serverAddr;
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &serverAddr.sin_addr);
+    assert(connect(clientSocket, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) == 0);
+
+    write(clientSocket, "?", 1);
+    char buffer[256];
+    int bytesRead = read(clientSocket, buffer, sizeof(buffer) - 1);
+    assert(bytesRead > 0);
+    buffer[bytesRead] = '\0';
+    close(clientSocket);
+    return std::string(buffer);
+}
+
+// Listening socket on a local port
+int listenOn(int port) {
+    int serverSocket = socket(AF_INET, SOCK_STREAM, 0);
+    assert(serverSocket >= 0);
+
+    int opt = 1;
+    setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+
+    assert(bind(serverSocket, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    assert(listen(serverSocket, 5) == 0);
+    return serverSocket;
+}
+
+// Test that two proactors in one process dispatch to their own handler and context
+void testProactorContext() {
+    std::cout << "\n=== Testing Proactor Context ===" << std::endl;
+
+    int serverA = listenOn(12347);
+    int serverB = listenOn(12348);
+
+    static const char tagA[] = "proactor-A";
+    static const char tagB[] = "proactor-B";
+    pthread_t tidA = startProactorCtx(serverA, taggedClientHandler, (void*)tagA);
+    pthread_t tidB = startProactorCtx(serverB, taggedClientHandler, (void*)tagB);
+    assert(tidA != 0 && tidB != 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    assert(requestReply(12347) == tagA);
+    assert(requestReply(12348) == tagB);
+    assert(requestReply(12347) == tagA);
+    std::cout << "✓ Independent proactor contexts test passed" << std::endl;
+
+    stopProactor(tidA);
+    stopProactor(tidB);
+    close(serverA);
+    close(serverB);
+}
+
 int main() {
     std::cout << "=== Reactor Library Test Suite ===" << std::endl;
     
     try {
         testReactor();
         testErrorConditions();
+        testContextCallbacks();
+        testPostToReactor();
         testSocketReactor();
         testProactor();
+        testProactorContext();
         
         std::cout << "\n🎉 ALL TESTS PASSED! 🎉" << std::endl;
         std::cout << "The reactor library is working correctly." << std::endl;
@@ -7,12 +7,18 @@
 // Function pointer type definition
 typedef void* (*reactorFunc)(int fd);
 
+// Callback type that also receives the context registered with the fd
+typedef void* (*reactorCtxFunc)(int fd, void* ctx);
+
 // Starts new reactor and returns pointer to it
 void* startReactor();
 
 // Adds fd to reactor (for reading); returns 0 on success
 int addFdToReactor(void* reactor, int fd, reactorFunc func);
 
+// Adds fd to reactor with a context pointer handed back to func; returns 0 on success
+int addFdToReactorCtx(void* reactor, int fd, reactorCtxFunc func, void* ctx);
+
 // Removes fd from reactor
 int removeFdFromReactor(void* reactor, int fd);
 
@@ -22,14 +28,27 @@ int stopReactor(void* reactor);
 // Run one iteration of the reactor event loop
 int runReactorOnce(void* reactor);
 
+// Task type run on the reactor thread by postToReactor
+typedef void (*reactorTask)(void* arg);
+
+// Queues task(arg) to run on the reactor thread and wakes the loop.
+// Safe to call from any thread while the reactor is alive; returns 0 on success
+int postToReactor(void* reactor, reactorTask task, void* arg);
+
 
 
 // Proactor additions
 typedef void* (*proactorFunc)(int sockfd);
 
+// Client handler that also receives the context given to startProactorCtx
+typedef void* (*proactorCtxFunc)(int sockfd, void* ctx);
+
 // Starts new proactor and returns proactor thread id
 pthread_t startProactor(int sockfd, proactorFunc threadFunc);
 
+// Starts new proactor whose client threads receive ctx; returns proactor thread id
+pthread_t startProactorCtx(int sockfd, proactorCtxFunc threadFunc, void* ctx);
+
 // Stops proactor by thread id
 int stopProactor(pthread_t tid);
 